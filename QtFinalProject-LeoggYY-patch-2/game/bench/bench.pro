@@ -0,0 +1,13 @@
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= app_bundle
+CONFIG -= qt
+
+SOURCES += \
+    benchmark.cpp \
+    main.cpp
+
+HEADERS += \
+    benchmark.h
+
+include(../engine/engine.pri)
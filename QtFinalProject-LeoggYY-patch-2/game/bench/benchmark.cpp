@@ -0,0 +1,235 @@
+﻿#include "benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <thread>
+
+namespace bench {
+
+namespace {
+
+std::vector<std::unique_ptr<Benchmark>> &registry() {
+    static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+double cpuNow() {
+    return double(std::clock()) / CLOCKS_PER_SEC;
+}
+
+struct Result {
+    std::string name;
+    int64_t iterations;
+    double realNanos;  // 每次迭代
+    double cpuNanos;
+    double itemsPerSecond;
+    std::string label;
+};
+
+std::string jsonEscape(const std::string &text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+std::string formatTime(double nanos) {
+    char buffer[32];
+    if (nanos < 1e4) std::snprintf(buffer, sizeof(buffer), "%.1f ns", nanos);
+    else if (nanos < 1e7) std::snprintf(buffer, sizeof(buffer), "%.1f us", nanos / 1e3);
+    else std::snprintf(buffer, sizeof(buffer), "%.1f ms", nanos / 1e6);
+    return buffer;
+}
+
+void writeJson(std::ostream &out, const std::string &executable, const std::vector<Result> &results) {
+    char date[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"executable\": \"" << jsonEscape(executable) << "\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+        << "    \"library_build_type\": \"release\"\n"
+#else
+        << "    \"library_build_type\": \"debug\"\n"
+#endif
+        << "  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        out << (i ? ",\n" : "\n") << "    {\n"
+            << "      \"name\": \"" << jsonEscape(r.name) << "\",\n"
+            << "      \"run_name\": \"" << jsonEscape(r.name) << "\",\n"
+            << "      \"run_type\": \"iteration\",\n"
+            << "      \"iterations\": " << r.iterations << ",\n"
+            << "      \"real_time\": " << r.realNanos << ",\n"
+            << "      \"cpu_time\": " << r.cpuNanos << ",\n"
+            << "      \"time_unit\": \"ns\"";
+        if (r.itemsPerSecond > 0) out << ",\n      \"items_per_second\": " << r.itemsPerSecond;
+        if (!r.label.empty()) out << ",\n      \"label\": \"" << jsonEscape(r.label) << "\"";
+        out << "\n    }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+bool startsWith(const char *text, const char *prefix, const char **value) {
+    size_t length = std::strlen(prefix);
+    if (std::strncmp(text, prefix, length) != 0) return false;
+    *value = text + length;
+    return true;
+}
+
+} // namespace
+
+// std::clock 讀一次比一次迭代還久 (而且精確度不夠)，每次暫停都讀的話 CPU 時間會比牆上時間還多；
+// 跟 Google Benchmark 一樣，CPU 時間只在迴圈開始和結束各讀一次，暫停只停牆上時間
+void State::PauseTiming() {
+    if (!running) return;
+    elapsed += Clock::now() - startTime;
+    running = false;
+}
+
+void State::ResumeTiming() {
+    if (running) return;
+    running = true;
+    startTime = Clock::now();
+}
+
+State::Iterator State::begin() {
+    cpuStart = cpuNow();
+    loopStart = Clock::now();
+    ResumeTiming();
+    return Iterator{ this, maxIterations };
+}
+
+void State::finish() {
+    PauseTiming();
+    loopElapsed = Clock::now() - loopStart;
+    cpuSeconds = cpuNow() - cpuStart;
+}
+
+bool State::Iterator::operator!=(const Iterator &) const {
+    if (remaining > 0) return true;
+    state->finish();  // 迴圈結束就停止計時
+    return false;
+}
+
+class Runner
+{
+public:
+    double minTime = 0.5;  // 每組參數至少跑幾秒
+
+    Result run(Benchmark &benchmark, const std::string &name, const std::vector<int64_t> &args) {
+        int64_t iterations = 1;
+        for (;;) {
+            State state(iterations, args);
+            benchmark.function(state);
+            double seconds = std::chrono::duration<double>(state.elapsed).count();
+
+            if (seconds >= minTime || iterations >= 1000000000) {
+                Result result;
+                result.name = name;
+                result.iterations = iterations;
+                result.realNanos = seconds * 1e9 / iterations;
+                // CPU 時間包含暫停的部分，依照沒暫停的牆上時間佔的比例扣掉 (沒暫停過時比例是 1)
+                double loopSeconds = std::chrono::duration<double>(state.loopElapsed).count();
+                double share = loopSeconds > 0 ? std::min(1.0, seconds / loopSeconds) : 1.0;
+                result.cpuNanos = state.cpuSeconds * share * 1e9 / iterations;
+                result.itemsPerSecond = state.itemsProcessed > 0 && seconds > 0 ? state.itemsProcessed / seconds : 0;
+                result.label = state.label;
+                return result;
+            }
+
+            // 跟 Google Benchmark 一樣，用這次的時間預估需要幾次，最多一次放大 10 倍
+            double multiplier = seconds > 0 ? minTime * 1.4 / seconds : 10.0;
+            multiplier = std::min(multiplier, 10.0);
+            iterations = std::max(iterations + 1, int64_t(iterations * multiplier));
+        }
+    }
+};
+
+Benchmark *registerBenchmark(const char *name, Benchmark::Function function) {
+    registry().push_back(std::make_unique<Benchmark>(name, std::move(function)));
+    return registry().back().get();
+}
+
+int runAll(int argc, char **argv) {
+    std::string filter = ".";
+    std::string format = "console";
+    std::string outPath;
+    bool listOnly = false;
+    Runner runner;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *value = nullptr;
+        if (startsWith(argv[i], "--benchmark_filter=", &value)) filter = value;
+        else if (startsWith(argv[i], "--benchmark_format=", &value)) format = value;
+        else if (startsWith(argv[i], "--benchmark_out=", &value)) outPath = value;
+        else if (startsWith(argv[i], "--benchmark_min_time=", &value)) runner.minTime = std::atof(value);  // "0.5" 或 "0.5s"
+        else if (std::strcmp(argv[i], "--benchmark_list_tests") == 0 || std::strcmp(argv[i], "--benchmark_list_tests=true") == 0) listOnly = true;
+        else {
+            std::fprintf(stderr, "usage: %s [--benchmark_filter=<regex>] [--benchmark_format=console|json]\n"
+                                 "          [--benchmark_out=<file.json>] [--benchmark_min_time=<seconds>] [--benchmark_list_tests]\n",
+                         argv[0]);
+            return 1;
+        }
+    }
+
+    std::regex pattern(filter);
+    bool console = format != "json";
+    std::vector<Result> results;
+
+    if (console && !listOnly) {
+        std::printf("%-48s %14s %14s %12s %16s\n", "Benchmark", "Time", "CPU", "Iterations", "items/s");
+        std::printf("%s\n", std::string(108, '-').c_str());
+    }
+
+    for (const auto &benchmark : registry()) {
+        std::vector<std::vector<int64_t>> argsList = benchmark->argsList;
+        if (argsList.empty()) argsList.push_back({});
+
+        for (const auto &args : argsList) {
+            std::string name = benchmark->name;
+            for (int64_t arg : args) name += "/" + std::to_string(arg);
+            if (!std::regex_search(name, pattern)) continue;
+            if (listOnly) {
+                std::printf("%s\n", name.c_str());
+                continue;
+            }
+
+            Result result = runner.run(*benchmark, name, args);
+            results.push_back(result);
+            if (console) {
+                char items[32] = "";
+                if (result.itemsPerSecond > 0) std::snprintf(items, sizeof(items), "%.1fM/s", result.itemsPerSecond / 1e6);
+                std::printf("%-48s %14s %14s %12lld %16s %s\n", name.c_str(), formatTime(result.realNanos).c_str(),
+                            formatTime(result.cpuNanos).c_str(), (long long)result.iterations, items, result.label.c_str());
+                std::fflush(stdout);
+            }
+        }
+    }
+
+    if (!console) writeJson(std::cout, argv[0], results);
+    if (!outPath.empty()) {
+        std::ofstream file(outPath);
+        if (!file) {
+            std::fprintf(stderr, "cannot write %s\n", outPath.c_str());
+            return 1;
+        }
+        writeJson(file, argv[0], results);
+    }
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,107 @@
+﻿#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// 很小的效能測試框架，介面照著 Google Benchmark 寫 (State、range()、PauseTiming、
+// SetItemsProcessed、--benchmark_filter、--benchmark_format=json ...)，
+// 輸出的 JSON 格式也一樣，可以直接丟給 Google Benchmark 的 compare.py 比較兩次 commit。
+// 不直接用 Google Benchmark 是因為 qmake 專案不好拉外部相依套件。
+namespace bench {
+
+class State
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    State(int64_t maxIterations, std::vector<int64_t> args)
+        : maxIterations(maxIterations), args(std::move(args)) {}
+
+    int64_t range(size_t i) const { return args.at(i); }
+    int64_t iterations() const { return maxIterations; }
+
+    void PauseTiming();   // 暫停計時 (準備資料的時間不算進去)，只停牆上時間
+    void ResumeTiming();
+    void SetItemsProcessed(int64_t items) { itemsProcessed = items; }
+    void SetLabel(const std::string &text) { label = text; }
+
+    // for (auto _ : state) { ... } 用的迭代器
+    struct [[maybe_unused]] Value {};  // 迴圈變數 _ 用不到，標成 maybe_unused 才不會有警告
+    struct Iterator {
+        State *state;
+        int64_t remaining;
+        bool operator!=(const Iterator &) const;
+        void operator++() { --remaining; }
+        Value operator*() const { return Value(); }
+    };
+    Iterator begin();
+    Iterator end() { return Iterator{ this, 0 }; }
+
+private:
+    friend class Runner;
+
+    void finish();  // 迴圈結束：停止計時，讀第二次 CPU 時間
+
+    int64_t maxIterations;
+    std::vector<int64_t> args;
+    int64_t itemsProcessed = 0;
+    std::string label;
+
+    bool running = false;
+    Clock::time_point startTime;
+    Clock::duration elapsed{};      // 沒有暫停的時間
+    Clock::time_point loopStart;
+    Clock::duration loopElapsed{};  // 整個迴圈 (含暫停)
+    double cpuStart = 0;
+    double cpuSeconds = 0;          // 整個迴圈 (含暫停) 用掉的 CPU 時間
+};
+
+// 一個效能測試 (函式 + 好幾組參數)
+class Benchmark
+{
+public:
+    using Function = std::function<void(State &)>;
+
+    Benchmark(std::string name, Function function)
+        : name(std::move(name)), function(std::move(function)) {}
+
+    Benchmark *Args(std::vector<int64_t> values) { argsList.push_back(std::move(values)); return this; }
+    Benchmark *Apply(void (*customizer)(Benchmark *)) { customizer(this); return this; }
+
+private:
+    friend class Runner;
+
+    void finish();  // 迴圈結束：停止計時，讀第二次 CPU 時間
+    friend int runAll(int argc, char **argv);
+
+    std::string name;
+    Function function;
+    std::vector<std::vector<int64_t>> argsList;
+};
+
+Benchmark *registerBenchmark(const char *name, Benchmark::Function function);
+int runAll(int argc, char **argv);  // 解析 --benchmark_* 參數並跑全部的測試
+
+// 避免編譯器把結果算都不算就丟掉
+template <class T>
+inline void DoNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const void *volatile sink;
+    sink = &value;
+#endif
+}
+
+} // namespace bench
+
+#define BENCH_CONCAT2(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT2(a, b)
+#define BENCHMARK(function) \
+    static bench::Benchmark *BENCH_CONCAT(registered_, __LINE__) = bench::registerBenchmark(#function, function)
+
+#endif // BENCHMARK_H
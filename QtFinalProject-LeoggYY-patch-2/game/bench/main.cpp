@@ -0,0 +1,328 @@
+﻿#include <algorithm>
+#include "benchmark.h"
+#include "bitboard.h"
+#include "chunkedboard.h"
+#include "minesweeperboard.h"
+#include "movejournal.h"
+
+// 遊戲邏輯的效能測試：產生盤面、展開空白、判斷勝利、完整玩一局
+// 參數是 rows/cols/mineCount (跟 Widget 的 setEasy/setNormal/setHard 一樣)，
+// 從內建難度一路到 10000x10000。
+//
+//   bench --benchmark_filter=FloodFill --benchmark_out=result.json
+//
+// 輸出的 JSON 跟 Google Benchmark 相同，可以用來比較不同 commit 的結果。
+
+namespace {
+
+using Strategy = MinesweeperBoard::CountStrategy;
+
+const int64_t presets[][3] = { { 10, 10, 10 }, { 15, 15, 60 }, { 20, 20, 80 } };  // easy / normal / hard
+
+// 內建難度 + 指定大小與地雷密度 (千分比)
+void addBoards(bench::Benchmark *b, std::initializer_list<int64_t> sizes, std::initializer_list<int64_t> permilles) {
+    for (const auto &preset : presets) {
+        b->Args({ preset[0], preset[1], preset[2] });
+    }
+    for (int64_t size : sizes) {
+        for (int64_t permille : permilles) {
+            b->Args({ size, size, size * size * permille / 1000 });
+        }
+    }
+}
+
+// 產生一個固定種子的盤面，之後每次迭代從這裡複製，不算進時間
+MinesweeperBoard makeBoard(const bench::State &state, uint64_t seed = 1) {
+    MinesweeperBoard board(int(state.range(0)), int(state.range(1)), int(state.range(2)));
+    board.initializeGame(seed);
+    return board;
+}
+
+// 放地雷 + 計算周圍地雷數 (initializeGame)，第 4 個參數是 CountStrategy
+void BM_Generate(bench::State &state) {
+    MinesweeperBoard board(int(state.range(0)), int(state.range(1)), int(state.range(2)));
+    board.setCountStrategy(Strategy(state.range(3)));
+    uint64_t seed = 1;
+    for (auto _ : state) {
+        state.PauseTiming();
+        board.clear();
+        state.ResumeTiming();
+        board.initializeGame(seed++);
+    }
+    state.SetItemsProcessed(state.iterations() * board.rows() * board.cols());
+}
+BENCHMARK(BM_Generate)->Apply([](bench::Benchmark *b) {
+    for (int64_t strategy : { int64_t(Strategy::Auto), int64_t(Strategy::Scatter), int64_t(Strategy::BoxFilter) }) {
+        for (const auto &preset : presets) {
+            b->Args({ preset[0], preset[1], preset[2], strategy });
+        }
+        for (int64_t size : { 100, 1000, 10000 }) {
+            for (int64_t permille : { 10, 100, 200 }) {
+                b->Args({ size, size, size * size * permille / 1000, strategy });
+            }
+        }
+    }
+});
+
+// BitBoard 的 initializeGame (放地雷 + 位元平面)，第 4 個參數是 BitBoard::Kernel，
+// 跟 BM_Generate 同樣的大小，可以直接比較
+void BM_BitboardGenerate(bench::State &state) {
+    BitBoard board(int(state.range(0)), int(state.range(1)), int(state.range(2)));
+    board.setKernel(BitBoard::Kernel(state.range(3)));
+    uint64_t seed = 1;
+    for (auto _ : state) {
+        state.PauseTiming();
+        board.clear();
+        state.ResumeTiming();
+        board.initializeGame(seed++);
+    }
+    state.SetItemsProcessed(state.iterations() * board.rows() * board.cols());
+    state.SetLabel(board.effectiveKernel() == BitBoard::Kernel::Avx2 ? "avx2" : "scalar");
+}
+BENCHMARK(BM_BitboardGenerate)->Apply([](bench::Benchmark *b) {
+    for (int64_t kernel : { int64_t(BitBoard::Kernel::Scalar), int64_t(BitBoard::Kernel::Avx2) }) {
+        for (const auto &preset : presets) {
+            b->Args({ preset[0], preset[1], preset[2], kernel });
+        }
+        for (int64_t size : { 100, 1000, 10000 }) {
+            for (int64_t permille : { 10, 100, 200 }) {
+                b->Args({ size, size, size * size * permille / 1000, kernel });
+            }
+        }
+    }
+});
+
+// 第一下：prepareGame 之後第一次 reveal 才放地雷 (放地雷 + 計算數字 + 展開)
+void BM_FirstReveal(bench::State &state) {
+    MinesweeperBoard board(int(state.range(0)), int(state.range(1)), int(state.range(2)));
+    uint64_t seed = 1;
+    for (auto _ : state) {
+        state.PauseTiming();
+        board.clear();
+        board.prepareGame(seed++);
+        state.ResumeTiming();
+        board.reveal(board.rows() / 2, board.cols() / 2);
+    }
+    state.SetItemsProcessed(state.iterations() * board.rows() * board.cols());
+}
+BENCHMARK(BM_FirstReveal)->Apply([](bench::Benchmark *b) {
+    addBoards(b, { 100, 1000 }, { 100, 200 });
+});
+
+// 超大盤面 (ChunkedBoard)：建立盤面 + 第一下，時間和記憶體只跟打開的區塊有關，跟盤面大小無關
+void BM_ChunkedOpen(bench::State &state) {
+    ChunkedBoard board;
+    uint64_t seed = 1;
+    int64_t opened = 0;
+    for (auto _ : state) {
+        board.reset(int(state.range(0)), int(state.range(1)), state.range(2), seed++);
+        board.reveal(board.rows() / 2, board.cols() / 2);
+        opened += int64_t(board.changedCells().size());
+    }
+    state.SetItemsProcessed(opened);
+    state.SetLabel("tiles " + std::to_string(board.tileCount()) + ", "
+                   + std::to_string(board.memoryUsage() / 1024) + " KB");
+}
+BENCHMARK(BM_ChunkedOpen)->Apply([](bench::Benchmark *b) {
+    for (int64_t size : { 1000, 10000, 100000 }) {
+        for (int64_t permille : { 100, 200 }) {
+            b->Args({ size, size, size * size * permille / 1000 });
+        }
+    }
+});
+
+// 無限模式：一路往右下走 (每走一個區塊就 keepAround + 點一下)，記憶體應該維持在固定範圍
+// 參數是走幾個區塊和地雷密度 (千分比)
+void BM_EndlessWalk(bench::State &state) {
+    ChunkedBoard board;
+    size_t peakMemory = 0;
+    size_t peakTiles = 0;
+    for (auto _ : state) {
+        board.resetEndless(1, double(state.range(1)) / 1000);
+        for (int64_t step = 0; step < state.range(0); ++step) {
+            int position = int(step) * ChunkedBoard::tileSize;
+            board.keepAround(position, position, 2);
+            board.reveal(position, position);  // 踩到地雷就重來
+            if (board.state() != ChunkedBoard::GameState::Playing) board.resetEndless(1, double(state.range(1)) / 1000);
+            peakMemory = std::max(peakMemory, board.memoryUsage());
+            peakTiles = std::max(peakTiles, board.tileCount());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetLabel("peak " + std::to_string(peakTiles) + " tiles, " + std::to_string(peakMemory / 1024) + " KB");
+}
+BENCHMARK(BM_EndlessWalk)->Apply([](bench::Benchmark *b) {
+    for (int64_t steps : { 100, 1000 }) {
+        for (int64_t permille : { 150, 200 }) {
+            b->Args({ steps, permille });
+        }
+    }
+});
+
+// 點一個空白格子，展開整個空白區域 (expandEmptyArea)
+void BM_FloodFill(bench::State &state) {
+    const MinesweeperBoard pristine = makeBoard(state);
+    int start = -1;
+    for (int i = 0; i < pristine.rows() && start < 0; ++i) {
+        for (int j = 0; j < pristine.cols(); ++j) {
+            if (pristine.value(i, j) == 0) {
+                start = pristine.index(i, j);
+                break;
+            }
+        }
+    }
+    if (start < 0) {
+        state.SetLabel("no empty cell");
+        for (auto _ : state) {}
+        return;
+    }
+
+    MinesweeperBoard board = pristine;
+    int64_t opened = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        board = pristine;
+        state.ResumeTiming();
+        board.revealAt(start);
+        opened += int64_t(board.changedCells().size());
+    }
+    state.SetItemsProcessed(opened);
+    state.SetLabel("opened " + std::to_string(opened / state.iterations()));
+}
+BENCHMARK(BM_FloodFill)->Apply([](bench::Benchmark *b) {
+    addBoards(b, { 100, 1000 }, { 10, 100, 200 });
+    b->Args({ 10000, 10000, 10000000 })->Args({ 10000, 10000, 20000000 });
+});
+
+// BitBoard 展開空白 (以 word 為單位)，跟 BM_FloodFill 同一個盤面、同一個起點
+void BM_BitboardFloodFill(bench::State &state) {
+    const MinesweeperBoard reference = makeBoard(state);
+    int startRow = -1, startCol = -1;
+    for (int i = 0; i < reference.rows() && startRow < 0; ++i) {
+        for (int j = 0; j < reference.cols(); ++j) {
+            if (reference.value(i, j) == 0) {
+                startRow = i;
+                startCol = j;
+                break;
+            }
+        }
+    }
+    if (startRow < 0) {
+        state.SetLabel("no empty cell");
+        for (auto _ : state) {}
+        return;
+    }
+
+    BitBoard pristine(reference.rows(), reference.cols(), reference.mineCount());
+    pristine.initializeGame(1);  // makeBoard 的種子
+    BitBoard board = pristine;
+    int64_t opened = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        board = pristine;
+        state.ResumeTiming();
+        board.reveal(startRow, startCol);
+        opened += board.lastChangeCount();
+    }
+    state.SetItemsProcessed(opened);
+    state.SetLabel("opened " + std::to_string(opened / state.iterations()));
+}
+BENCHMARK(BM_BitboardFloodFill)->Apply([](bench::Benchmark *b) {
+    addBoards(b, { 100, 1000 }, { 10, 100, 200 });
+    b->Args({ 10000, 10000, 10000000 })->Args({ 10000, 10000, 20000000 });
+});
+
+// 悔掉 BM_FloodFill 那一下：時間只跟打開的格子數有關 (跟 BM_FloodFill 比較)
+void BM_UndoFloodFill(bench::State &state) {
+    MinesweeperBoard board = makeBoard(state);
+    int start = -1;
+    for (int i = 0; i < board.rows() && start < 0; ++i) {
+        for (int j = 0; j < board.cols(); ++j) {
+            if (board.value(i, j) == 0) {
+                start = board.index(i, j);
+                break;
+            }
+        }
+    }
+    if (start < 0) {
+        state.SetLabel("no empty cell");
+        for (auto _ : state) {}
+        return;
+    }
+
+    MoveJournal journal;
+    MinesweeperBoard::GameState before = board.state();
+    board.revealAt(start);
+    journal.record(board, before);
+    int64_t restored = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        journal.redo(board);
+        state.ResumeTiming();
+        journal.undo(board);
+        restored += int64_t(board.changedCells().size());
+    }
+    state.SetItemsProcessed(restored);
+    state.SetLabel("restored " + std::to_string(restored / state.iterations()) + ", journal "
+                   + std::to_string(journal.memoryUsage() / 1024) + " KiB");
+}
+BENCHMARK(BM_UndoFloodFill)->Apply([](bench::Benchmark *b) {
+    addBoards(b, { 100, 1000 }, { 10, 100, 200 });
+    b->Args({ 10000, 10000, 10000000 })->Args({ 10000, 10000, 20000000 });
+});
+
+// 把每個地雷都插上旗子，每一步都要判斷有沒有贏
+void BM_WinDetection(bench::State &state) {
+    const MinesweeperBoard pristine = makeBoard(state);
+    std::vector<int> mines;
+    for (int i = 0; i < pristine.rows(); ++i) {
+        for (int j = 0; j < pristine.cols(); ++j) {
+            if (pristine.isMine(i, j)) mines.push_back(pristine.index(i, j));
+        }
+    }
+
+    MinesweeperBoard board = pristine;
+    for (auto _ : state) {
+        state.PauseTiming();
+        board = pristine;
+        state.ResumeTiming();
+        for (int index : mines) {
+            board.toggleFlagAt(index);
+        }
+        bench::DoNotOptimize(board.state());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mines.size()));
+}
+BENCHMARK(BM_WinDetection)->Apply([](bench::Benchmark *b) {
+    addBoards(b, { 100, 1000 }, { 100, 200 });
+});
+
+// 由左上到右下打開每一個安全的格子 (一整局不會踩到地雷的遊戲)
+void BM_FullGame(bench::State &state) {
+    const MinesweeperBoard pristine = makeBoard(state);
+    MinesweeperBoard board = pristine;
+    int64_t clicks = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        board = pristine;
+        state.ResumeTiming();
+        for (int i = 0; i < board.rows(); ++i) {
+            for (int j = 0; j < board.cols(); ++j) {
+                if (board.isMine(i, j) || board.isRevealed(i, j)) continue;
+                board.reveal(i, j);
+                ++clicks;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t(board.rows()) * board.cols() - board.mineCount()));
+    state.SetLabel("clicks " + std::to_string(clicks / state.iterations()));
+}
+BENCHMARK(BM_FullGame)->Apply([](bench::Benchmark *b) {
+    addBoards(b, { 100, 1000 }, { 100, 200 });
+});
+
+} // namespace
+
+int main(int argc, char **argv) {
+    return bench::runAll(argc, argv);
+}
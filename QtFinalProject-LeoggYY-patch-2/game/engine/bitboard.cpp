@@ -0,0 +1,368 @@
+﻿#include "bitboard.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BITBOARD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define BITBOARD_AVX2  // MSVC 不用另外開啟就能使用 AVX2 intrinsics
+#else
+#define BITBOARD_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define BITBOARD_X86 0
+#endif
+
+namespace {
+
+inline int popcount(uint64_t x) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    return int((((x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL) * 0x0101010101010101ULL) >> 56);
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+// 全加器：三個 1 位元輸入，sum 是個位、carry 是進位 (64 個格子同時算)
+inline void fullAdd(uint64_t a, uint64_t b, uint64_t c, uint64_t &sum, uint64_t &carry) {
+    uint64_t t = a ^ b;
+    sum = t ^ c;
+    carry = (a & b) | (t & c);
+}
+
+// 8 個鄰居的位元加起來，得到 4 位元的數字 (0~8)
+inline void addEight(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f, uint64_t g, uint64_t h,
+                     uint64_t &bit0, uint64_t &bit1, uint64_t &bit2, uint64_t &bit3) {
+    uint64_t s1, c1, s2, c2, c4, s5, c5;
+    fullAdd(a, b, c, s1, c1);
+    fullAdd(d, e, f, s2, c2);
+    uint64_t s3 = g ^ h, c3 = g & h;
+    fullAdd(s1, s2, s3, bit0, c4);  // 個位完成，c1~c4 都是 2 的位數
+    fullAdd(c1, c2, c3, s5, c5);
+    bit1 = s5 ^ c4;
+    uint64_t c6 = s5 & c4;          // c5、c6 是 4 的位數
+    bit2 = c5 ^ c6;
+    bit3 = c5 & c6;
+}
+
+// 從 seeds 開始，在 mask 裡往左右填滿連續的位元 (Kogge-Stone occluded fill，固定 12 步)
+inline uint64_t fillWithin(uint64_t seeds, uint64_t mask) {
+    uint64_t up = seeds, p = mask;
+    up |= p & (up << 1);  p &= p << 1;
+    up |= p & (up << 2);  p &= p << 2;
+    up |= p & (up << 4);  p &= p << 4;
+    up |= p & (up << 8);  p &= p << 8;
+    up |= p & (up << 16); p &= p << 16;
+    up |= p & (up << 32);
+    uint64_t down = seeds;
+    p = mask;
+    down |= p & (down >> 1);  p &= p >> 1;
+    down |= p & (down >> 2);  p &= p >> 2;
+    down |= p & (down >> 4);  p &= p >> 4;
+    down |= p & (down >> 8);  p &= p >> 8;
+    down |= p & (down >> 16); p &= p >> 16;
+    down |= p & (down >> 32);
+    return up | down;
+}
+
+} // namespace
+
+BitBoard::BitBoard(int rows, int cols, int mineCount)
+{
+    resize(rows, cols, mineCount);
+}
+
+void BitBoard::resize(int rows, int cols, int mineCount) {
+    // 跟 MinesweeperBoard::resize 一樣把大小和地雷數限制在合理範圍 (地雷太多時放地雷會除以 0)
+    m_rows = std::max(rows, 0);
+    m_cols = std::max(cols, 0);
+    m_mineCount = std::clamp(mineCount, 0, m_rows * m_cols);
+    wordsPerRow = (m_cols + 63) / 64;
+    stride = wordsPerRow + 2;
+    lastMask = (m_cols & 63) ? (uint64_t(1) << (m_cols & 63)) - 1 : ~uint64_t(0);
+    const size_t size = size_t(m_rows + 2) * stride;
+    for (std::vector<uint64_t> *bits : { &mines, &revealed, &flags, &zero, &planes[0], &planes[1], &planes[2], &planes[3] }) {
+        bits->assign(size, 0);
+    }
+    clear();
+}
+
+void BitBoard::clear() {
+    for (std::vector<uint64_t> *bits : { &mines, &revealed, &flags, &zero, &planes[0], &planes[1], &planes[2], &planes[3] }) {
+        std::fill(bits->begin(), bits->end(), 0);
+    }
+    markBorder();
+    m_flagCount = 0;
+    m_correctCount = 0;
+    m_revealedCount = 0;
+    m_lastChangeCount = 0;
+    m_state = GameState::Playing;
+    changed.clear();
+}
+
+void BitBoard::markBorder() {
+    std::fill(revealed.begin(), revealed.begin() + stride, ~uint64_t(0));
+    std::fill(revealed.end() - stride, revealed.end(), ~uint64_t(0));
+    for (int i = 1; i <= m_rows; ++i) {
+        uint64_t *row = revealed.data() + size_t(i) * stride;
+        row[0] = ~uint64_t(0);
+        row[stride - 1] = ~uint64_t(0);
+        if (wordsPerRow > 0) row[wordsPerRow] |= ~lastMask;  // 最後一個 word 超出盤面的部分
+    }
+}
+
+void BitBoard::initializeGame(uint64_t seed) {
+    generate(seed, nullptr, 0);
+}
+
+void BitBoard::initializeGame(uint64_t seed, int safeRow, int safeCol) {
+    // 跟 MinesweeperBoard::initializeGame 一樣避開 (safeRow, safeCol) 和周圍 8 格
+    int excluded[9];
+    int excludedCount = 0;
+    if (isValid(safeRow, safeCol)) {
+        for (int i = safeRow - 1; i <= safeRow + 1; ++i) {
+            for (int j = safeCol - 1; j <= safeCol + 1; ++j) {
+                if (isValid(i, j)) excluded[excludedCount++] = i * m_cols + j;
+            }
+        }
+        if (m_mineCount > m_rows * m_cols - excludedCount) {
+            excluded[0] = safeRow * m_cols + safeCol;
+            excludedCount = m_mineCount < m_rows * m_cols ? 1 : 0;
+        }
+    }
+    generate(seed, excluded, excludedCount);
+}
+
+void BitBoard::generate(uint64_t seed, const int *excluded, int excludedCount) {
+    rng.setSeed(seed);
+
+    // 跟 MinesweeperBoard::placeMines 同樣的 Floyd 取樣和編號方式
+    auto cellAt = [&](int t) {
+        for (int k = 0; k < excludedCount && excluded[k] <= t; ++k) ++t;
+        return t;
+    };
+    const int n = m_rows * m_cols - excludedCount;
+    for (int j = n - m_mineCount; j < n; ++j) {
+        int t = cellAt(int(rng.bounded(uint64_t(j) + 1)));
+        if (isMine(t / m_cols, t % m_cols)) t = cellAt(j);
+        mines[wordIndex(t / m_cols, t % m_cols)] |= uint64_t(1) << ((t % m_cols) & 63);
+    }
+    countMines();
+}
+
+BitBoard::Kernel BitBoard::effectiveKernel() const {
+    if (m_kernel == Kernel::Scalar) return Kernel::Scalar;
+    return avx2Supported() ? Kernel::Avx2 : Kernel::Scalar;
+}
+
+bool BitBoard::avx2Supported() {
+#if BITBOARD_X86 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5));
+#elif BITBOARD_X86
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+void BitBoard::countMines() {
+    if (effectiveKernel() == Kernel::Avx2) {
+        countRowsAvx2(0, m_rows - 1);
+    } else {
+        countRowsScalar(0, m_rows - 1);
+    }
+}
+
+void BitBoard::countRowsScalar(int firstRow, int lastRow) {
+    for (int i = firstRow; i <= lastRow; ++i) {
+        const size_t base = size_t(i + 1) * stride;
+        const uint64_t *up = mines.data() + base - stride;
+        const uint64_t *mid = mines.data() + base;
+        const uint64_t *down = mines.data() + base + stride;
+        for (int w = 1; w <= wordsPerRow; ++w) {
+            // 左邊的鄰居 (col - 1) 要往高位元移一格，缺的那一位從前一個 word 補
+            uint64_t b0, b1, b2, b3;
+            addEight((up[w] << 1) | (up[w - 1] >> 63), up[w], (up[w] >> 1) | (up[w + 1] << 63),
+                     (mid[w] << 1) | (mid[w - 1] >> 63), (mid[w] >> 1) | (mid[w + 1] << 63),
+                     (down[w] << 1) | (down[w - 1] >> 63), down[w], (down[w] >> 1) | (down[w + 1] << 63),
+                     b0, b1, b2, b3);
+            const size_t p = base + w;
+            planes[0][p] = b0;
+            planes[1][p] = b1;
+            planes[2][p] = b2;
+            planes[3][p] = b3;
+            zero[p] = ~(b0 | b1 | b2 | b3 | mid[w]) & (w == wordsPerRow ? lastMask : ~uint64_t(0));
+        }
+    }
+}
+
+#if BITBOARD_X86
+// 一次 4 個 word 的全加器 (intrinsics 在 lambda 裡不會繼承 target 屬性，所以用巨集)
+#define BITBOARD_FULL_ADD(a, b, c, sum, carry) \
+    do { \
+        __m256i t_ = _mm256_xor_si256(a, b); \
+        sum = _mm256_xor_si256(t_, c); \
+        carry = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(t_, c)); \
+    } while (0)
+
+BITBOARD_AVX2 void BitBoard::countRowsAvx2(int firstRow, int lastRow) {
+    for (int i = firstRow; i <= lastRow; ++i) {
+        const size_t base = size_t(i + 1) * stride;
+        const uint64_t *rows[3] = { mines.data() + base - stride, mines.data() + base, mines.data() + base + stride };
+        int w = 1;
+        for (; w + 3 <= wordsPerRow; w += 4) {
+            __m256i left[3], centre[3], right[3];
+            for (int k = 0; k < 3; ++k) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[k] + w));
+                __m256i before = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[k] + w - 1));
+                __m256i after = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[k] + w + 1));
+                left[k] = _mm256_or_si256(_mm256_slli_epi64(x, 1), _mm256_srli_epi64(before, 63));
+                right[k] = _mm256_or_si256(_mm256_srli_epi64(x, 1), _mm256_slli_epi64(after, 63));
+                centre[k] = x;
+            }
+            // 跟 addEight 一樣的電路
+            __m256i s1, c1, s2, c2, b0, c4, s5, c5;
+            BITBOARD_FULL_ADD(left[0], centre[0], right[0], s1, c1);
+            BITBOARD_FULL_ADD(left[1], right[1], left[2], s2, c2);
+            __m256i s3 = _mm256_xor_si256(centre[2], right[2]);
+            __m256i c3 = _mm256_and_si256(centre[2], right[2]);
+            BITBOARD_FULL_ADD(s1, s2, s3, b0, c4);
+            BITBOARD_FULL_ADD(c1, c2, c3, s5, c5);
+            __m256i b1 = _mm256_xor_si256(s5, c4);
+            __m256i c6 = _mm256_and_si256(s5, c4);
+            __m256i b2 = _mm256_xor_si256(c5, c6);
+            __m256i b3 = _mm256_and_si256(c5, c6);
+
+            const size_t p = base + w;
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(planes[0].data() + p), b0);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(planes[1].data() + p), b1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(planes[2].data() + p), b2);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(planes[3].data() + p), b3);
+            __m256i any = _mm256_or_si256(_mm256_or_si256(b0, b1), _mm256_or_si256(_mm256_or_si256(b2, b3), centre[1]));
+            __m256i valid = _mm256_set_epi64x(w + 3 == wordsPerRow ? int64_t(lastMask) : -1, -1, -1, -1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(zero.data() + p), _mm256_andnot_si256(any, valid));
+        }
+        if (w <= wordsPerRow) countRowsScalar(i, i);  // 剩下不到 4 個 word (整列重算，很短)
+    }
+}
+#undef BITBOARD_FULL_ADD
+#else
+void BitBoard::countRowsAvx2(int firstRow, int lastRow) {
+    countRowsScalar(firstRow, lastRow);
+}
+#endif
+
+int BitBoard::value(int row, int col) const {
+    if (isMine(row, col)) return -1;
+    const int p = wordIndex(row, col);
+    const int bit = col & 63;
+    return int((planes[0][p] >> bit) & 1) | int(((planes[1][p] >> bit) & 1) << 1)
+           | int(((planes[2][p] >> bit) & 1) << 2) | int(((planes[3][p] >> bit) & 1) << 3);
+}
+
+BitBoard::RevealResult BitBoard::reveal(int row, int col) {
+    changed.clear();
+    m_lastChangeCount = 0;
+    if (!isValid(row, col) || m_state != GameState::Playing) return RevealResult::Ignored;
+    const int p = wordIndex(row, col);
+    const uint64_t bit = uint64_t(1) << (col & 63);
+    if ((revealed[p] | flags[p]) & bit) return RevealResult::Ignored;
+
+    if (mines[p] & bit) { // 點到地雷
+        revealed[p] |= bit;
+        changed.push_back({ p, bit });
+        m_lastChangeCount = 1;
+        m_state = GameState::Lost;
+        return RevealResult::Exploded;
+    }
+    if (zero[p] & bit) {
+        expandEmptyArea(p, bit);
+    } else {
+        openBits(p, bit);
+    }
+    checkWin();
+    return RevealResult::Opened;
+}
+
+void BitBoard::openBits(int word, uint64_t bits) {
+    revealed[word] |= bits;
+    int count = popcount(bits);
+    m_revealedCount += count;
+    m_lastChangeCount += count;
+    changed.push_back({ word, bits });
+}
+
+void BitBoard::touch(int word, uint64_t bits) {
+    // 空白格子的鄰居一定不是地雷，沒打開、沒插旗子的數字直接打開，空白的之後再展開
+    bits &= ~(revealed[word] | flags[word]);
+    if (!bits) return;
+    if (uint64_t numbers = bits & ~zero[word]) openBits(word, numbers);
+    if (uint64_t empty = bits & zero[word]) floodStack.push_back({ word, empty });
+}
+
+void BitBoard::expandEmptyArea(int word, uint64_t seed) {
+    floodStack.clear();
+    floodStack.push_back({ word, seed });
+    while (!floodStack.empty()) {
+        Seed s = floodStack.back();
+        floodStack.pop_back();
+        const int p = s.word;
+        const uint64_t open = zero[p] & ~(revealed[p] | flags[p]);  // 這個 word 裡還能展開的空白格子
+        if (!(s.bits & open)) continue;
+
+        // 這個 word 裡連在一起的空白格子一次打開，再處理周圍一圈
+        const uint64_t region = fillWithin(s.bits & open, open);
+        openBits(p, region);
+        const uint64_t around = region | (region << 1) | (region >> 1);
+        touch(p, around);
+        touch(p - stride, around);
+        touch(p + stride, around);
+        if (region & 1) { // 最低位元的鄰居在前一個 word 的最高位元
+            const uint64_t high = uint64_t(1) << 63;
+            touch(p - 1, high);
+            touch(p - 1 - stride, high);
+            touch(p - 1 + stride, high);
+        }
+        if (region >> 63) {
+            touch(p + 1, 1);
+            touch(p + 1 - stride, 1);
+            touch(p + 1 + stride, 1);
+        }
+    }
+}
+
+BitBoard::FlagResult BitBoard::toggleFlag(int row, int col) {
+    changed.clear();
+    m_lastChangeCount = 0;
+    if (!isValid(row, col) || m_state != GameState::Playing) return FlagResult::Ignored;
+    const int p = wordIndex(row, col);
+    const uint64_t bit = uint64_t(1) << (col & 63);
+    if (revealed[p] & bit) return FlagResult::Ignored;
+
+    flags[p] ^= bit;
+    const bool placed = flags[p] & bit;
+    changed.push_back({ p, bit });
+    m_lastChangeCount = 1;
+    const int delta = placed ? 1 : -1;
+    m_flagCount += delta;
+    if (mines[p] & bit) m_correctCount += delta;
+    checkWin();
+    return placed ? FlagResult::Placed : FlagResult::Removed;
+}
+
+void BitBoard::checkWin() {
+    bool flagsDone = m_mineCount == m_correctCount && m_mineCount == m_flagCount;
+    bool revealDone = m_revealedCount == safeCount();
+    if ((m_winRule != WinRule::RevealSafe && flagsDone) || (m_winRule != WinRule::FlagMines && revealDone))
+        m_state = GameState::Won;
+}
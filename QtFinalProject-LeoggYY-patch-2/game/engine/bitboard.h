@@ -0,0 +1,125 @@
+﻿#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+#include <vector>
+#include "gamerandom.h"
+#include "minesweeperboard.h"
+
+// 另一種盤面表示法：每一列存成位元集合 (一個 uint64_t 放 64 個格子)，
+// 地雷、已打開、旗子、空白各一組，周圍地雷數存成 4 個位元平面 (bit 0~3)。
+//  - 周圍地雷數：上中下三列左右移一格得到 8 個鄰居的位元，用加法器電路 (bit-sliced)
+//    一次加 64 個格子；CPU 支援 AVX2 時一次處理 4 個 word (256 個格子)
+//  - 展開空白：以 word 為單位，一個 word 裡的空白格子一次填滿 (occluded fill)，
+//    再把周圍一圈的位元往上下左右的 word 擴散，不用一格一格走
+//
+// 地雷的放法和 MinesweeperBoard 一模一樣，同一個種子產生同一個盤面，可以互相對照。
+// 跟 MinesweeperBoard 一樣外面多包一圈：每列左右各多一個 word、上下各多一列，
+// 邊框和盤面外的位元都標成已打開，展開時自然會停下。
+class BitBoard
+{
+public:
+    using RevealResult = MinesweeperBoard::RevealResult;
+    using FlagResult = MinesweeperBoard::FlagResult;
+    using GameState = MinesweeperBoard::GameState;
+    using WinRule = MinesweeperBoard::WinRule;
+
+    // 計算周圍地雷數用的指令集
+    enum class Kernel {
+        Auto,    // CPU 支援 AVX2 就用 AVX2
+        Scalar,  // 一次一個 uint64_t
+        Avx2     // 一次四個 uint64_t (CPU 不支援時退回 Scalar)
+    };
+
+    // 上一個動作改變的格子：第 word 個 word 裡的 bits
+    struct WordChange {
+        int word;
+        uint64_t bits;
+    };
+
+    BitBoard(int rows = 10, int cols = 10, int mineCount = 10);
+
+    void resize(int rows, int cols, int mineCount);  // 改變大小並清空盤面
+    void clear();  // 清空盤面 (保留大小)
+    void initializeGame(uint64_t seed);  // 跟 MinesweeperBoard::initializeGame 產生同一個盤面
+    void initializeGame(uint64_t seed, int safeRow, int safeCol);
+
+    void setKernel(Kernel kernel) { m_kernel = kernel; }
+    Kernel kernel() const { return m_kernel; }
+    Kernel effectiveKernel() const;  // Auto (或不支援的 Avx2) 實際會用哪一個
+    static bool avx2Supported();
+
+    void setWinRule(WinRule rule) { m_winRule = rule; }
+    WinRule winRule() const { return m_winRule; }
+
+    RevealResult reveal(int row, int col);
+    FlagResult toggleFlag(int row, int col);
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int mineCount() const { return m_mineCount; }
+    int flagCount() const { return m_flagCount; }
+    int correctCount() const { return m_correctCount; }
+    int revealedCount() const { return m_revealedCount; }  // 打開的安全格子數
+    int safeCount() const { return m_rows * m_cols - m_mineCount; }
+    GameState state() const { return m_state; }
+
+    bool isValid(int row, int col) const { return row >= 0 && row < m_rows && col >= 0 && col < m_cols; }
+    bool isMine(int row, int col) const { return test(mines, row, col); }
+    bool isRevealed(int row, int col) const { return test(revealed, row, col); }
+    bool isFlagged(int row, int col) const { return test(flags, row, col); }
+    int value(int row, int col) const;  // -1 代表地雷，其餘為周圍地雷數
+
+    const std::vector<WordChange> &changedWords() const { return changed; }
+    int lastChangeCount() const { return m_lastChangeCount; }  // 上一個動作改變了幾個格子
+
+    // 第 word 個 word 對應的列和第一個格子的行
+    int rowOfWord(int word) const { return word / stride - 1; }
+    int colOfWord(int word) const { return (word % stride - 1) * 64; }
+
+private:
+    int wordIndex(int row, int col) const { return (row + 1) * stride + (col >> 6) + 1; }
+    bool test(const std::vector<uint64_t> &bits, int row, int col) const {
+        return (bits[wordIndex(row, col)] >> (col & 63)) & 1;
+    }
+
+    void markBorder();  // 邊框和盤面外的位元標成已打開
+    void generate(uint64_t seed, const int *excluded, int excludedCount);
+    void countMines();  // 算出位元平面和空白格子
+    void countRowsScalar(int firstRow, int lastRow);
+    void countRowsAvx2(int firstRow, int lastRow);
+    void openBits(int word, uint64_t bits);  // 打開一個 word 裡的一些安全格子
+    void touch(int word, uint64_t bits);     // 空白區域周圍的格子：數字直接打開，空白繼續展開
+    void expandEmptyArea(int word, uint64_t seed);
+    void checkWin();  // 同 MinesweeperBoard::checkWin
+
+    int m_rows = 0;
+    int m_cols = 0;
+    int m_mineCount = 0;
+    int m_flagCount = 0;
+    int m_correctCount = 0;
+    int m_revealedCount = 0;
+    int m_lastChangeCount = 0;
+    GameState m_state = GameState::Playing;
+    WinRule m_winRule = WinRule::Either;
+    Kernel m_kernel = Kernel::Auto;
+
+    int wordsPerRow = 0;  // (cols + 63) / 64
+    int stride = 0;       // wordsPerRow + 2
+    uint64_t lastMask = 0;  // 每列最後一個 word 裡屬於盤面的位元
+    std::vector<uint64_t> mines;
+    std::vector<uint64_t> revealed;
+    std::vector<uint64_t> flags;
+    std::vector<uint64_t> zero;       // 沒有地雷、周圍也沒有地雷的格子
+    std::vector<uint64_t> planes[4];  // 周圍地雷數的第 0~3 個位元
+
+    struct Seed {
+        int word;
+        uint64_t bits;
+    };
+    std::vector<Seed> floodStack;
+    std::vector<WordChange> changed;
+    GameRandom rng;
+};
+
+#endif // BITBOARD_H
@@ -0,0 +1,779 @@
+﻿#include "chunkedboard.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+// floor(a * b / c)，a * b 可能超過 64 位元
+uint64_t mulDiv(uint64_t a, uint64_t b, uint64_t c) {
+    if (b == c) return a;
+#if defined(__SIZEOF_INT128__)
+    return uint64_t((unsigned __int128)a * b / c);
+#else
+    return uint64_t((long double)a * b / c);  // MSVC 沒有 128 位元整數，結果一樣是遞增的
+#endif
+}
+
+// 暫存檔裡一區的資料：依序寫進 / 讀出固定大小的數字
+template <typename T>
+void putValue(std::vector<uint8_t> &out, T value) {
+    const size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+struct ValueReader {
+    const std::vector<uint8_t> &data;
+    size_t at = 0;
+    template <typename T>
+    bool get(T &value) {
+        if (data.size() - at < sizeof(T)) return false;
+        std::memcpy(&value, data.data() + at, sizeof(T));
+        at += sizeof(T);
+        return true;
+    }
+};
+
+size_t bucketOf(uint64_t regionKey, int buckets) {
+    return size_t((regionKey * 0x9E3779B97F4A7C15ull) >> 32) % size_t(buckets);
+}
+} // namespace
+
+ChunkedBoard::ChunkedBoard(int rows, int cols, int64_t mineCount, uint64_t seed)
+{
+    reset(rows, cols, mineCount, seed);
+}
+
+void ChunkedBoard::reset(int rows, int cols, int64_t mineCount, uint64_t seed) {
+    m_endless = false;
+    m_rows = std::max(rows, 0);
+    m_cols = std::max(cols, 0);
+    m_mineCount = std::clamp<int64_t>(mineCount, 0, int64_t(m_rows) * m_cols);
+    m_seed = seed;
+    clearTiles();
+}
+
+void ChunkedBoard::resetEndless(uint64_t seed, double density) {
+    m_endless = true;
+    m_rows = 0;
+    m_cols = 0;
+    m_mineCount = 0;
+    endlessTileMines = int(std::clamp(density, 0.0, 1.0) * tileSize * tileSize + 0.5);
+    m_seed = seed;
+    clearTiles();
+}
+
+void ChunkedBoard::clearTiles() {
+    m_flagCount = 0;
+    m_correctCount = 0;
+    m_revealedCount = 0;
+    m_state = GameState::Playing;
+    tiles.clear();
+    lastKey = ~0ull;
+    lastTile = nullptr;
+    changed.clear();
+    activeRow = 0;
+    activeCol = 0;
+    safeRadius = -1;
+    regions.clear();
+    m_storedTileCount = 0;
+    if (swapUsed) resetSwapFile();  // 舊的區不能再被找到
+}
+
+int64_t ChunkedBoard::tileMineCount(int tileRow, int tileCol) const {
+    // 區塊依照列優先排好，前面的區塊一共有 before 個格子，
+    // 地雷數取 mineCount * 格子數 / 總格子數 的整數部分相減，加起來剛好是 mineCount
+    if (m_endless) return endlessTileMines;
+    const uint64_t total = uint64_t(m_rows) * uint64_t(m_cols);
+    if (total == 0) return 0;
+    const uint64_t height = uint64_t(std::min(tileSize, m_rows - (tileRow << tileShift)));
+    const uint64_t rowStart = uint64_t(tileRow) * tileSize * uint64_t(m_cols);
+    const uint64_t begin = rowStart + height * uint64_t(tileCol) * tileSize;
+    const uint64_t end = rowStart + height * uint64_t(std::min((tileCol + 1) * tileSize, m_cols));
+    return int64_t(mulDiv(uint64_t(m_mineCount), end, total) - mulDiv(uint64_t(m_mineCount), begin, total));
+}
+
+ChunkedBoard::Tile *ChunkedBoard::findTile(int tileRow, int tileCol) const {
+    auto it = tiles.find(keyOf(tileRow, tileCol));
+    return it == tiles.end() ? nullptr : it->second.get();
+}
+
+ChunkedBoard::Tile *ChunkedBoard::tileWithMines(int tileRow, int tileCol) {
+    uint64_t key = keyOf(tileRow, tileCol);
+    if (lastTile && key == lastKey) return lastTile;
+    std::unique_ptr<Tile> &slot = tiles[key];
+    if (!slot) {
+        slot = std::make_unique<Tile>();
+        placeMines(slot.get(), tileRow, tileCol);
+        if (m_endless) restoreTile(key, slot.get());
+    }
+    lastKey = key;
+    lastTile = slot.get();
+    return lastTile;
+}
+
+ChunkedBoard::Tile *ChunkedBoard::tileWithCounts(int tileRow, int tileCol) {
+    Tile *tile = tileWithMines(tileRow, tileCol);
+    if (!tile->counted) countTile(tile, tileRow, tileCol);
+    return tile;
+}
+
+void ChunkedBoard::placeMines(Tile *tile, int tileRow, int tileCol) {
+    // 種子和區塊座標打散成這個區塊自己的亂數
+    uint64_t state = m_seed ^ (keyOf(tileRow, tileCol) * 0x9E3779B97F4A7C15ull);
+    GameRandom random(GameRandom::splitMix64(state));
+
+    // 第一下周圍在這個區塊裡的格子 (區塊裡的順序，由小到大) 不能放地雷，取樣時跳過
+    const int width = tileWidth(tileCol);
+    int excluded[9];
+    int excludedCount = 0;
+    if (safeRadius >= 0) {
+        for (int r = safeRow - safeRadius; r <= safeRow + safeRadius; ++r) {
+            for (int c = safeCol - safeRadius; c <= safeCol + safeRadius; ++c) {
+                if (isValid(r, c) && (r >> tileShift) == tileRow && (c >> tileShift) == tileCol)
+                    excluded[excludedCount++] = (r & (tileSize - 1)) * width + (c & (tileSize - 1));
+            }
+        }
+    }
+    const int n = tileHeight(tileRow) * width - excludedCount;
+    const int mines = int(tileMineCount(tileRow, tileCol));
+    auto cellAt = [&](int t) {
+        for (int i = 0; i < excludedCount && excluded[i] <= t; ++i) ++t;
+        return (t / width) * tileSize + t % width;
+    };
+    for (int j = n - mines; j < n; ++j) { // Floyd 取樣，跟 MinesweeperBoard::placeMines 一樣
+        int idx = cellAt(int(random.bounded(uint64_t(j) + 1)));
+        if (tile->cells[idx] & CellBits::MineBit) idx = cellAt(j);
+        tile->cells[idx] |= CellBits::MineBit;
+    }
+}
+
+void ChunkedBoard::countTile(Tile *tile, int tileRow, int tileCol) {
+    // 把自己和周圍 8 個區塊的地雷拼成 (64+2) x (64+2) 的點陣，再對每個格子加總 3x3
+    constexpr int padded = tileSize + 2;
+    uint8_t mines[padded * padded] = {};
+    for (int dr = -1; dr <= 1; ++dr) {
+        for (int dc = -1; dc <= 1; ++dc) {
+            int tr = tileRow + dr;
+            int tc = tileCol + dc;
+            if (!hasTile(tr, tc)) continue;
+            const Tile *source = (dr == 0 && dc == 0) ? tile : tileWithMines(tr, tc);
+            // 這個區塊在拼好的點陣裡需要的範圍 (鄰居只需要靠近的一列或一行)
+            int rowFrom = dr < 0 ? tileSize - 1 : 0, rowTo = dr > 0 ? 0 : tileSize - 1;
+            int colFrom = dc < 0 ? tileSize - 1 : 0, colTo = dc > 0 ? 0 : tileSize - 1;
+            for (int r = rowFrom; r <= rowTo; ++r) {
+                for (int c = colFrom; c <= colTo; ++c) {
+                    mines[(r + 1 + dr * tileSize) * padded + c + 1 + dc * tileSize] =
+                        (source->cells[r * tileSize + c] >> 4) & 1;
+                }
+            }
+        }
+    }
+    lastKey = keyOf(tileRow, tileCol);  // tileWithMines 可能把快取換成鄰居
+    lastTile = tile;
+
+    for (int r = 0; r < tileSize; ++r) {
+        const uint8_t *above = mines + r * padded;
+        const uint8_t *middle = above + padded;
+        const uint8_t *below = middle + padded;
+        for (int c = 0; c < tileSize; ++c) {
+            int count = above[c] + above[c + 1] + above[c + 2] + middle[c] + middle[c + 2]
+                        + below[c] + below[c + 1] + below[c + 2];
+            tile->cells[r * tileSize + c] |= uint8_t(count);
+        }
+    }
+    tile->counted = true;
+}
+
+uint8_t ChunkedBoard::cell(int row, int col) const {
+    const Tile *tile = findTile(row >> tileShift, col >> tileShift);
+    return tile ? tile->cells[(row & (tileSize - 1)) * tileSize + (col & (tileSize - 1))] : 0;
+}
+
+int ChunkedBoard::value(int row, int col) const {
+    uint8_t c = cell(row, col);
+    return (c & CellBits::MineBit) ? -1 : (c & CellBits::CountMask);
+}
+
+uint8_t &ChunkedBoard::cellRef(int row, int col) {
+    Tile *tile = tileWithCounts(row >> tileShift, col >> tileShift);
+    return tile->cells[(row & (tileSize - 1)) * tileSize + (col & (tileSize - 1))];
+}
+
+ChunkedBoard::RevealResult ChunkedBoard::reveal(int row, int col) {
+    changed.clear();
+    if (!isValid(row, col) || m_state != GameState::Playing) return RevealResult::Ignored;
+    if (!isActive(row >> tileShift, col >> tileShift)) moveActiveArea(row >> tileShift, col >> tileShift, activeRadius);
+    // 還沒打開過任何格子就是第一下 (先插旗子也算)
+    if (m_revealedCount == 0 && !(cell(row, col) & CellBits::FlagBit)) protectFirstClick(row, col);
+    uint8_t &c = cellRef(row, col);
+    if (c & (CellBits::RevealedBit | CellBits::FlagBit)) return RevealResult::Ignored;
+
+    if (c & CellBits::MineBit) { // 點到地雷
+        c |= CellBits::RevealedBit;
+        changed.push_back({ row, col });
+        m_state = GameState::Lost;
+        return RevealResult::Exploded;
+    }
+    floodStack.clear();
+    openCell(c, row, col);
+    expandEmptyArea();
+    checkWin();
+    return RevealResult::Opened;
+}
+
+void ChunkedBoard::protectFirstClick(int row, int col) {
+    // 跟 MinesweeperBoard::prepareGame 一樣先試 3x3，放不下再只保證點到的格子。
+    // 區塊的地雷數只跟位置有關，所以要看每個碰到的區塊扣掉不能放的格子之後還放不放得下；
+    // 點到的區塊整塊都是地雷時就沒辦法避開
+    for (int radius = 1; radius >= 0; --radius) {
+        const int top = (row - radius) >> tileShift;
+        const int bottom = (row + radius) >> tileShift;
+        const int left = (col - radius) >> tileShift;
+        const int right = (col + radius) >> tileShift;
+        bool fits = true;
+        for (int tr = top; tr <= bottom; ++tr) {
+            for (int tc = left; tc <= right; ++tc) {
+                if (!hasTile(tr, tc)) continue;
+                int excluded = 0;
+                for (int r = row - radius; r <= row + radius; ++r) {
+                    for (int c = col - radius; c <= col + radius; ++c) {
+                        if (isValid(r, c) && (r >> tileShift) == tr && (c >> tileShift) == tc) ++excluded;
+                    }
+                }
+                if (tileMineCount(tr, tc) > int64_t(tileHeight(tr)) * tileWidth(tc) - excluded) fits = false;
+            }
+        }
+        if (!fits) continue;
+
+        // 種子不變，只有這幾個區塊的地雷會動：已經配置的重新放 (旗子留著)，旁邊一圈的數字重算
+        safeRow = row;
+        safeCol = col;
+        safeRadius = radius;
+        for (int tr = top - 1; tr <= bottom + 1; ++tr) {
+            for (int tc = left - 1; tc <= right + 1; ++tc) {
+                Tile *tile = findTile(tr, tc);
+                if (!tile) continue;
+                const bool moved = tr >= top && tr <= bottom && tc >= left && tc <= right;
+                for (uint8_t &cell : tile->cells) {
+                    if (moved && (cell & CellBits::FlagBit) && (cell & CellBits::MineBit)) --m_correctCount;
+                    cell &= moved ? uint8_t(CellBits::FlagBit) : uint8_t(~CellBits::CountMask);
+                }
+                tile->counted = false;
+                if (!moved) continue;
+                placeMines(tile, tr, tc);
+                for (uint8_t cell : tile->cells) {
+                    if ((cell & CellBits::FlagBit) && (cell & CellBits::MineBit)) ++m_correctCount;
+                }
+            }
+        }
+        return;
+    }
+}
+
+void ChunkedBoard::openCell(uint8_t &cell, int row, int col) {
+    cell |= CellBits::RevealedBit;
+    ++m_revealedCount;
+    changed.push_back({ row, col });
+    if ((cell & CellBits::CountMask) == 0) floodStack.push_back({ row, col });
+}
+
+void ChunkedBoard::expandEmptyArea() {
+    // 跟 MinesweeperBoard::expandEmptyArea 一樣放進堆疊時就標成已打開；
+    // 展開到哪個區塊才配置那個區塊，碰到活動範圍外的區塊就先記在 pendingFlood
+    while (!floodStack.empty()) {
+        Position p = floodStack.back();
+        floodStack.pop_back();
+        for (int dr = -1; dr <= 1; ++dr) {
+            for (int dc = -1; dc <= 1; ++dc) {
+                int r = p.row + dr;
+                int c = p.col + dc;
+                if ((dr == 0 && dc == 0) || !isValid(r, c)) continue;
+                if (!isActive(r >> tileShift, c >> tileShift)) {
+                    addPending(r, c);
+                    continue;
+                }
+                uint8_t &next = cellRef(r, c);
+                if (next & (CellBits::RevealedBit | CellBits::FlagBit)) continue;
+                openCell(next, r, c);
+            }
+        }
+    }
+}
+
+void ChunkedBoard::keepAround(int row, int col, int radius) {
+    changed.clear();
+    moveActiveArea(row >> tileShift, col >> tileShift, std::max(radius, 1));
+}
+
+void ChunkedBoard::moveActiveArea(int tileRow, int tileCol, int radius) {
+    activeRow = tileRow;
+    activeCol = tileCol;
+    activeRadius = radius;
+
+    // 無限模式才壓縮範圍外的區塊 (有邊界的盤面打開過的區塊就留著)；
+    // 活動範圍要用到外面一圈區塊的地雷算數字，所以再多留一圈才壓縮
+    if (m_endless) {
+        std::vector<uint64_t> evicted;
+        for (const auto &entry : tiles) {
+            int tr = int(int32_t(entry.first >> 32));
+            int tc = int(int32_t(uint32_t(entry.first)));
+            if (std::abs(tr - activeRow) > radius + 2 || std::abs(tc - activeCol) > radius + 2) evicted.push_back(entry.first);
+        }
+        for (uint64_t key : evicted) {
+            storeTile(key, tiles[key].get());
+            tiles.erase(key);
+        }
+        lastKey = ~0ull;
+        lastTile = nullptr;
+    }
+
+    // 進到範圍裡、之前存起來的區塊要拿回來 (畫面才看得到打開過的格子)，
+    // 有等著展開的格子就繼續展開
+    if (!regions.empty() || swapUsed) {
+        floodStack.clear();
+        for (int tr = activeRow - radius; tr <= activeRow + radius; ++tr) {
+            for (int tc = activeCol - radius; tc <= activeCol + radius; ++tc) {
+                StoredRegion *region = findRegion(tr, tc, false);
+                if (!region) continue;
+                const uint64_t key = keyOf(tr, tc);
+                if (region->tiles.count(key)) tileWithCounts(tr, tc);
+                auto it = region->pending.find(key);
+                if (it == region->pending.end()) continue;
+                std::vector<uint16_t> cells = std::move(it->second);
+                region->pending.erase(it);
+                region->dirty = true;
+                for (uint16_t at : cells) {
+                    const int row = (tr << tileShift) + at / tileSize;
+                    const int col = (tc << tileShift) + at % tileSize;
+                    uint8_t &c = cellRef(row, col);
+                    if (!(c & (CellBits::RevealedBit | CellBits::FlagBit))) openCell(c, row, col);
+                }
+                expandEmptyArea();
+            }
+        }
+    }
+    trimRegions();
+}
+
+void ChunkedBoard::storeTile(uint64_t key, const Tile *tile) {
+    // 地雷和數字都可以重新產生，只要留下打開/旗子的位元；完全沒動過的區塊直接丟掉
+    std::vector<uint8_t> data;
+    constexpr int n = tileSize * tileSize;
+    bool touched = false;
+    for (int i = 0; i < n;) {
+        uint8_t bits = (tile->cells[i] & (CellBits::RevealedBit | CellBits::FlagBit)) >> 5;
+        int run = 1;
+        while (i + run < n && run < 64 && ((tile->cells[i + run] & (CellBits::RevealedBit | CellBits::FlagBit)) >> 5) == bits) ++run;
+        data.push_back(uint8_t(bits << 6 | (run - 1)));
+        touched |= bits != 0;
+        i += run;
+    }
+    if (!touched) return;
+
+    StoredRegion *region = findRegion(int(int32_t(key >> 32)), int(int32_t(uint32_t(key))), true);
+    std::vector<uint8_t> &slot = region->tiles[key];
+    if (slot.empty()) ++m_storedTileCount;
+    slot = std::move(data);
+    region->dirty = true;
+}
+
+void ChunkedBoard::restoreTile(uint64_t key, Tile *tile) {
+    StoredRegion *region = findRegion(int(int32_t(key >> 32)), int(int32_t(uint32_t(key))), false);
+    if (!region) return;
+    auto it = region->tiles.find(key);
+    if (it == region->tiles.end()) return;
+    int i = 0;
+    for (uint8_t byte : it->second) {
+        uint8_t bits = uint8_t((byte >> 6) << 5);
+        for (int run = (byte & 63) + 1; run > 0; --run) {
+            tile->cells[i++] |= bits;
+        }
+    }
+    region->tiles.erase(it);  // 空掉的區等 trimRegions 再丟 (呼叫的人可能還拿著指標)
+    region->dirty = true;
+    --m_storedTileCount;
+}
+
+void ChunkedBoard::addPending(int row, int col) {
+    const int tileRow = row >> tileShift;
+    const int tileCol = col >> tileShift;
+    StoredRegion *region = findRegion(tileRow, tileCol, true);
+    region->pending[keyOf(tileRow, tileCol)].push_back(uint16_t((row & (tileSize - 1)) * tileSize + (col & (tileSize - 1))));
+    region->dirty = true;
+}
+
+ChunkedBoard::StoredRegion *ChunkedBoard::findRegion(int tileRow, int tileCol, bool create) {
+    const uint64_t key = keyOf(tileRow >> regionShift, tileCol >> regionShift);
+    auto it = regions.find(key);
+    if (it != regions.end()) return &it->second;
+    if (!create && !swapUsed) return nullptr;
+    // 暫存檔裡也沒有的話留一個空的，離開範圍之前不用再讀檔
+    StoredRegion &region = regions[key];
+    if (swapUsed) readRegion(key, region);
+    return &region;
+}
+
+void ChunkedBoard::trimRegions() {
+    // 活動範圍 (加上算數字和展開會碰到的外圈) 碰得到的區留著，其他的空區直接丟，
+    // 總大小超過上限時寫到暫存檔 (沒改過的區暫存檔裡已經有了)
+    const int margin = activeRadius + 2;
+    auto nearActive = [&](uint64_t key) {
+        const int top = int(int32_t(key >> 32)) << regionShift;
+        const int left = int(int32_t(uint32_t(key))) << regionShift;
+        const int last = (1 << regionShift) - 1;
+        return top + last >= activeRow - margin && top <= activeRow + margin
+               && left + last >= activeCol - margin && left <= activeCol + margin;
+    };
+    size_t total = 0;
+    for (auto it = regions.begin(); it != regions.end();) {
+        if (it->second.empty() && !it->second.onDisk && !nearActive(it->first)) {
+            it = regions.erase(it);
+        } else {
+            total += regionBytes(it->second);
+            ++it;
+        }
+    }
+    if (!swapFile.is_open() || total <= swapLimit) return;
+    for (auto it = regions.begin(); it != regions.end() && total > swapLimit;) {
+        if (nearActive(it->first) || (it->second.dirty && !writeRegion(it->first, it->second))) {
+            ++it;
+            continue;
+        }
+        total -= regionBytes(it->second);
+        it = regions.erase(it);
+    }
+}
+
+size_t ChunkedBoard::regionBytes(const StoredRegion &region) {
+    // 雜湊表每個節點大約多兩個指標
+    size_t bytes = sizeof(StoredRegion) + sizeof(uint64_t) + sizeof(void *) * 4;
+    for (const auto &entry : region.tiles) {
+        bytes += sizeof(entry) + sizeof(void *) * 2 + entry.second.capacity();
+    }
+    for (const auto &entry : region.pending) {
+        bytes += sizeof(entry) + sizeof(void *) * 2 + entry.second.capacity() * sizeof(uint16_t);
+    }
+    return bytes;
+}
+
+bool ChunkedBoard::writeRegion(uint64_t key, StoredRegion &region) {
+    // 每一筆是 區的 key、同一串的上一筆、資料長度、保留的長度、資料 (後面留一點空間)。
+    // 同一區再寫時放得下就直接蓋掉原來那一筆，放不下才接在檔案最後面，
+    // 再把雜湊表指到新的這一筆 (舊的那筆變成沒用的空間；清空的區寫一筆長度 0 的)
+    std::vector<uint8_t> data;
+    putValue(data, uint32_t(region.tiles.size()));
+    for (const auto &entry : region.tiles) {
+        putValue(data, entry.first);
+        putValue(data, uint32_t(entry.second.size()));
+        data.insert(data.end(), entry.second.begin(), entry.second.end());
+    }
+    putValue(data, uint32_t(region.pending.size()));
+    for (const auto &entry : region.pending) {
+        putValue(data, entry.first);
+        putValue(data, uint32_t(entry.second.size()));
+        for (uint16_t at : entry.second) putValue(data, at);
+    }
+    if (region.empty()) data.clear();
+
+    if (region.diskOffset >= 0 && data.size() <= region.diskCapacity) {
+        std::vector<uint8_t> record;
+        putValue(record, uint32_t(data.size()));
+        putValue(record, region.diskCapacity);
+        record.insert(record.end(), data.begin(), data.end());
+        swapFile.seekp(region.diskOffset + int64_t(sizeof(uint64_t) + sizeof(int64_t)));  // key 和上一筆不用動
+        swapFile.write(reinterpret_cast<const char *>(record.data()), std::streamsize(record.size()));
+        if (!swapFile) {
+            swapFile.clear();
+            return false;
+        }
+        return true;
+    }
+
+    const int64_t head = int64_t(bucketOf(key, swapBuckets) * sizeof(int64_t));
+    int64_t previous = -1;
+    swapFile.seekg(head);
+    swapFile.read(reinterpret_cast<char *>(&previous), sizeof(previous));
+    const int64_t offset = swapEnd;
+    const uint32_t capacity = uint32_t(data.size() + data.size() / 4);  // 多留 1/4，之後多打開幾格還放得下
+    std::vector<uint8_t> record;
+    putValue(record, key);
+    putValue(record, previous);
+    putValue(record, uint32_t(data.size()));
+    putValue(record, capacity);
+    record.insert(record.end(), data.begin(), data.end());
+    record.resize(swapRecordHeader + capacity);
+    swapFile.seekp(offset);
+    swapFile.write(reinterpret_cast<const char *>(record.data()), std::streamsize(record.size()));
+    if (swapFile) {
+        swapFile.seekp(head);
+        swapFile.write(reinterpret_cast<const char *>(&offset), sizeof(offset));
+    }
+    if (!swapFile) {
+        swapFile.clear();  // 寫不進去就留在記憶體
+        return false;
+    }
+    if (region.diskOffset >= 0) swapDead += swapRecordHeader + region.diskCapacity;
+    region.diskOffset = offset;
+    region.diskCapacity = capacity;
+    swapEnd = offset + int64_t(record.size());
+    swapUsed = true;
+    // 沒用的空間超過檔案的一半 (而且夠大) 就整理一次，來回走的時候檔案才不會一直變大
+    if (swapDead > swapCompactBytes && swapDead * 2 > swapEnd) compactSwapFile();
+    return true;
+}
+
+bool ChunkedBoard::readRegion(uint64_t key, StoredRegion &region) {
+    int64_t offset = -1;
+    swapFile.seekg(int64_t(bucketOf(key, swapBuckets) * sizeof(int64_t)));
+    swapFile.read(reinterpret_cast<char *>(&offset), sizeof(offset));
+    while (swapFile && offset >= 0) {
+        uint64_t recordKey = 0;
+        int64_t previous = -1;
+        uint32_t size = 0;
+        uint32_t capacity = 0;
+        swapFile.seekg(offset);
+        swapFile.read(reinterpret_cast<char *>(&recordKey), sizeof(recordKey));
+        swapFile.read(reinterpret_cast<char *>(&previous), sizeof(previous));
+        swapFile.read(reinterpret_cast<char *>(&size), sizeof(size));
+        swapFile.read(reinterpret_cast<char *>(&capacity), sizeof(capacity));
+        if (!swapFile || recordKey != key) {
+            offset = previous;
+            continue;
+        }
+        region.diskOffset = offset;
+        region.diskCapacity = capacity;
+        std::vector<uint8_t> data(size);
+        swapFile.read(reinterpret_cast<char *>(data.data()), size);
+        ValueReader reader{ data };
+        uint32_t count = 0;
+        if (swapFile && reader.get(count)) {
+            for (uint32_t i = 0; i < count; ++i) {
+                uint64_t tileKey = 0;
+                uint32_t length = 0;
+                if (!reader.get(tileKey) || !reader.get(length) || data.size() - reader.at < length) break;
+                region.tiles[tileKey].assign(data.begin() + std::ptrdiff_t(reader.at), data.begin() + std::ptrdiff_t(reader.at + length));
+                reader.at += length;
+            }
+            if (reader.get(count)) {
+                for (uint32_t i = 0; i < count; ++i) {
+                    uint64_t tileKey = 0;
+                    uint32_t length = 0;
+                    if (!reader.get(tileKey) || !reader.get(length)) break;
+                    std::vector<uint16_t> &cells = region.pending[tileKey];
+                    uint16_t at = 0;
+                    for (uint32_t j = 0; j < length && reader.get(at); ++j) cells.push_back(at);
+                }
+            }
+        }
+        region.onDisk = size > 0;
+        break;
+    }
+    swapFile.clear();
+    return region.onDisk;
+}
+
+bool ChunkedBoard::compactSwapFile() {
+    // 每一串從新到舊走，每一區只留最新的一筆 (長度 0 的也不要)，照原來的順序寫到新檔案再換掉舊的；
+    // 記憶體裡的區記著自己在檔案裡的位置，要跟著改
+    const std::string compactPath = swapPath + ".compact";
+    std::fstream out(compactPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    std::vector<int64_t> heads(swapBuckets, -1);
+    swapFile.seekg(0);
+    swapFile.read(reinterpret_cast<char *>(heads.data()), std::streamsize(heads.size() * sizeof(int64_t)));
+    out.write(reinterpret_cast<const char *>(heads.data()), std::streamsize(heads.size() * sizeof(int64_t)));
+    std::unordered_map<uint64_t, std::pair<int64_t, uint32_t>> moved;  // 區的 key -> 新的位置和保留的長度
+    int64_t end = int64_t(heads.size() * sizeof(int64_t));
+    for (int64_t &head : heads) {
+        std::vector<std::pair<uint64_t, std::vector<uint8_t>>> live;
+        std::unordered_map<uint64_t, bool> seen;
+        for (int64_t offset = head; swapFile && offset >= 0;) {
+            uint64_t key = 0;
+            uint32_t size = 0;
+            uint32_t capacity = 0;
+            swapFile.seekg(offset);
+            swapFile.read(reinterpret_cast<char *>(&key), sizeof(key));
+            swapFile.read(reinterpret_cast<char *>(&offset), sizeof(offset));
+            swapFile.read(reinterpret_cast<char *>(&size), sizeof(size));
+            swapFile.read(reinterpret_cast<char *>(&capacity), sizeof(capacity));
+            if (!swapFile || seen[key] || size == 0) {
+                seen[key] = true;
+                continue;
+            }
+            seen[key] = true;
+            std::vector<uint8_t> data(size);
+            swapFile.read(reinterpret_cast<char *>(data.data()), size);
+            live.emplace_back(key, std::move(data));
+        }
+        head = -1;
+        for (auto it = live.rbegin(); it != live.rend(); ++it) {
+            const uint32_t size = uint32_t(it->second.size());
+            const uint32_t capacity = size + size / 4;
+            std::vector<uint8_t> record;
+            putValue(record, it->first);
+            putValue(record, head);
+            putValue(record, size);
+            putValue(record, capacity);
+            record.insert(record.end(), it->second.begin(), it->second.end());
+            record.resize(swapRecordHeader + capacity);
+            out.write(reinterpret_cast<const char *>(record.data()), std::streamsize(record.size()));
+            moved[it->first] = { end, capacity };
+            head = end;
+            end += int64_t(record.size());
+        }
+    }
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(heads.data()), std::streamsize(heads.size() * sizeof(int64_t)));
+    const bool ok = bool(swapFile) && bool(out);
+    out.close();
+    swapFile.clear();
+    if (!ok) {
+        std::remove(compactPath.c_str());  // 整理失敗就繼續用舊的檔案
+        return false;
+    }
+    swapFile.close();
+    std::remove(swapPath.c_str());
+    if (std::rename(compactPath.c_str(), swapPath.c_str()) != 0) {
+        // 換不過去：舊檔案已經刪了，記憶體裡的區全部當作沒寫過，重新開一個空的
+        for (auto &entry : regions) {
+            entry.second.onDisk = false;
+            entry.second.dirty = true;
+            entry.second.diskOffset = -1;
+        }
+        std::remove(compactPath.c_str());
+        resetSwapFile();
+        return false;
+    }
+    swapFile.open(swapPath, std::ios::in | std::ios::out | std::ios::binary);
+    for (auto &entry : regions) {
+        auto it = moved.find(entry.first);
+        entry.second.diskOffset = it == moved.end() ? -1 : it->second.first;
+        entry.second.diskCapacity = it == moved.end() ? 0 : it->second.second;
+    }
+    swapEnd = end;
+    swapDead = 0;
+    return swapFile.is_open();
+}
+
+bool ChunkedBoard::resetSwapFile() {
+    // 開頭是 swapBuckets 個 -1 (每一串都是空的)
+    swapUsed = false;
+    swapEnd = int64_t(swapBuckets * sizeof(int64_t));
+    swapDead = 0;
+    if (swapFile.is_open()) swapFile.close();
+    if (swapPath.empty()) return false;
+    swapFile.open(swapPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    const std::vector<int64_t> heads(swapBuckets, -1);
+    swapFile.write(reinterpret_cast<const char *>(heads.data()), std::streamsize(heads.size() * sizeof(int64_t)));
+    if (swapFile) return true;
+    swapFile.close();
+    return false;
+}
+
+bool ChunkedBoard::setSwapFile(const std::string &path, size_t memoryLimit) {
+    // 之前寫到舊檔案的區要先全部讀回記憶體 (沿著雜湊表的每一串找出每一區)
+    if (swapUsed) {
+        std::vector<int64_t> heads(swapBuckets, -1);
+        swapFile.seekg(0);
+        swapFile.read(reinterpret_cast<char *>(heads.data()), std::streamsize(heads.size() * sizeof(int64_t)));
+        for (int64_t offset : heads) {
+            while (swapFile && offset >= 0) {
+                uint64_t key = 0;
+                swapFile.seekg(offset);
+                swapFile.read(reinterpret_cast<char *>(&key), sizeof(key));
+                swapFile.read(reinterpret_cast<char *>(&offset), sizeof(offset));
+                if (swapFile && !regions.count(key)) readRegion(key, regions[key]);
+            }
+            swapFile.clear();
+        }
+        for (auto &entry : regions) {
+            entry.second.onDisk = false;
+            entry.second.dirty = true;
+            entry.second.diskOffset = -1;
+        }
+    }
+    swapLimit = memoryLimit;
+    swapPath = path;
+    return resetSwapFile();
+}
+
+ChunkedBoard::RevealResult ChunkedBoard::chord(int row, int col) {
+    changed.clear();
+    if (!isValid(row, col) || m_state != GameState::Playing) return RevealResult::Ignored;
+    // 周圍 8 格可能在隔壁的區塊：活動範圍要包含它們 (範圍外的格子不能先記在 pendingFlood，可能是地雷)
+    const int tileRow = row >> tileShift;
+    const int tileCol = col >> tileShift;
+    if (!isActive((row - 1) >> tileShift, (col - 1) >> tileShift) || !isActive((row + 1) >> tileShift, (col + 1) >> tileShift))
+        moveActiveArea(tileRow, tileCol, activeRadius);
+    const uint8_t c = cellRef(row, col);
+    if ((c & (CellBits::RevealedBit | CellBits::MineBit)) != CellBits::RevealedBit || !(c & CellBits::CountMask))
+        return RevealResult::Ignored;  // 只有打開的數字可以
+
+    int flags = 0;
+    for (int dr = -1; dr <= 1; ++dr) {
+        for (int dc = -1; dc <= 1; ++dc) {
+            if ((dr || dc) && isValid(row + dr, col + dc) && (cellRef(row + dr, col + dc) & CellBits::FlagBit)) ++flags;
+        }
+    }
+    if (flags != (c & CellBits::CountMask)) return RevealResult::Ignored;
+
+    // 周圍的格子全部先打開，空白的放進 floodStack，只跑一次展開
+    bool exploded = false;
+    floodStack.clear();
+    for (int dr = -1; dr <= 1; ++dr) {
+        for (int dc = -1; dc <= 1; ++dc) {
+            if ((dr == 0 && dc == 0) || !isValid(row + dr, col + dc)) continue;
+            uint8_t &next = cellRef(row + dr, col + dc);
+            if (next & (CellBits::RevealedBit | CellBits::FlagBit)) continue;
+            if (next & CellBits::MineBit) {
+                next |= CellBits::RevealedBit;
+                changed.push_back({ row + dr, col + dc });
+                exploded = true;
+            } else {
+                openCell(next, row + dr, col + dc);
+            }
+        }
+    }
+    expandEmptyArea();
+
+    if (exploded) {
+        m_state = GameState::Lost;
+        return RevealResult::Exploded;
+    }
+    checkWin();
+    return changed.empty() ? RevealResult::Ignored : RevealResult::Opened;
+}
+
+ChunkedBoard::FlagResult ChunkedBoard::toggleFlag(int row, int col) {
+    changed.clear();
+    if (!isValid(row, col) || m_state != GameState::Playing) return FlagResult::Ignored;
+    if (!isActive(row >> tileShift, col >> tileShift)) moveActiveArea(row >> tileShift, col >> tileShift, activeRadius);
+    uint8_t &c = cellRef(row, col);
+    if (c & CellBits::RevealedBit) return FlagResult::Ignored;
+
+    c ^= CellBits::FlagBit;
+    bool placed = c & CellBits::FlagBit;
+    changed.push_back({ row, col });
+    int delta = placed ? 1 : -1;
+    m_flagCount += delta;
+    if (c & CellBits::MineBit) m_correctCount += delta;
+    checkWin();
+    return placed ? FlagResult::Placed : FlagResult::Removed;
+}
+
+void ChunkedBoard::checkWin() {
+    if (m_endless) return;
+    bool flagsDone = m_mineCount == m_correctCount && m_mineCount == m_flagCount;
+    bool revealDone = m_revealedCount == int64_t(m_rows) * m_cols - m_mineCount;
+    if ((m_winRule != WinRule::RevealSafe && flagsDone) || (m_winRule != WinRule::FlagMines && revealDone))
+        m_state = GameState::Won;
+}
+
+size_t ChunkedBoard::memoryUsage() const {
+    size_t stored = 0;
+    for (const auto &entry : regions) {
+        stored += regionBytes(entry.second);
+    }
+    return tiles.size() * (sizeof(Tile) + sizeof(void *) * 4) + stored
+           + changed.capacity() * sizeof(Position) + floodStack.capacity() * sizeof(Position);
+}
@@ -0,0 +1,190 @@
+﻿#ifndef CHUNKEDBOARD_H
+#define CHUNKEDBOARD_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "gamerandom.h"
+#include "minesweeperboard.h"
+
+// 超大盤面 (例如 100000 x 100000)：整個盤面切成 64x64 的區塊，碰到才配置。
+// 每個區塊的地雷只由種子和區塊座標決定，所以不用先產生整個盤面，
+// 建立盤面是 O(1)，記憶體只跟玩家打開過 (和旁邊) 的區塊數成正比。
+//
+// 每個區塊的地雷數固定是總數按照格子數平均分配 (各區塊加起來剛好是 mineCount)，
+// 區塊裡的位置用 Floyd 取樣。格子的位元跟 MinesweeperBoard::CellBits 一樣。
+// 第一下跟 MinesweeperBoard::prepareGame 一樣，點到的格子和周圍 3x3 不放地雷
+// (那幾個區塊放地雷時跳過這些格子，區塊太密放不下就只保證點到的格子)。
+//
+// 展開只會在「活動範圍」(keepAround 設定，通常是畫面附近) 裡的區塊進行，
+// 展開碰到範圍外的區塊時先記下來，等那個區塊進到範圍裡才繼續展開，
+// 所以地雷很少的超大盤面第一下也不會一次展開 (配置) 整個盤面。
+//
+// 無限模式 (resetEndless)：沒有邊界，每個區塊的地雷數固定 (密度 x 64 x 64)。
+// 離開活動範圍的區塊只留下打開/旗子的位元，
+// 壓縮 (run-length) 之後存起來 (地雷和數字可以從種子重新算)。
+// 存起來的區塊和等著展開的格子每 16x16 個區塊分成一區，有設定暫存檔 (setSwapFile) 的話，
+// 超過上限時活動範圍外的區整區寫到暫存檔 (連索引一起，檔案開頭是雜湊表；
+// 同一區再寫時盡量蓋掉原來那一筆，被取代的空間太多就整理一次)，
+// 記憶體裡只剩活動範圍附近的區，不管玩家走多遠都不會變多；沒有暫存檔就全部留在記憶體。
+class ChunkedBoard
+{
+public:
+    using RevealResult = MinesweeperBoard::RevealResult;
+    using FlagResult = MinesweeperBoard::FlagResult;
+    using GameState = MinesweeperBoard::GameState;
+    using WinRule = MinesweeperBoard::WinRule;
+    using CellBits = MinesweeperBoard::CellBits;
+
+    static constexpr int tileShift = 6;
+    static constexpr int tileSize = 1 << tileShift;  // 區塊的邊長
+    static constexpr int defaultRadius = 8;          // 預設的活動範圍 (區塊)
+
+    struct Position {
+        int row;
+        int col;
+    };
+
+    ChunkedBoard(int rows = 0, int cols = 0, int64_t mineCount = 0, uint64_t seed = 0);
+
+    void reset(int rows, int cols, int64_t mineCount, uint64_t seed);  // 丟掉所有區塊 (O(區塊數))
+    void resetEndless(uint64_t seed, double density);  // 無限模式，density 是地雷密度 (0~1)
+
+    // 把活動範圍移到 (row, col) 所在的區塊周圍 radius 個區塊，之前停在範圍邊上的展開會繼續
+    // (打開的格子在 changedCells)；無限模式範圍外的區塊會壓縮存起來
+    void keepAround(int row, int col, int radius = defaultRadius);
+    // 存起來的資料超過 memoryLimit byte 就把活動範圍外的區寫到 path 這個暫存檔，開不了檔案回傳 false；
+    // path 是空的就不用暫存檔 (之前寫出去的區讀回記憶體，舊的檔案由呼叫的人刪掉)
+    bool setSwapFile(const std::string &path, size_t memoryLimit);
+
+    RevealResult reveal(int row, int col);  // 打開格子，空白格子會跨區塊展開 (第一下周圍 3x3 一定安全)
+    FlagResult toggleFlag(int row, int col);
+    RevealResult chord(int row, int col);  // 同 MinesweeperBoard::chord
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int64_t mineCount() const { return m_mineCount; }  // 無限模式是 0
+    bool endless() const { return m_endless; }
+    int64_t flagCount() const { return m_flagCount; }
+    int64_t revealedCount() const { return m_revealedCount; }
+    int64_t correctCount() const { return m_correctCount; }
+    // 無限模式永遠不會贏 (沒有「全部」)，其他跟 MinesweeperBoard 一樣
+    void setWinRule(WinRule rule) { m_winRule = rule; }
+    WinRule winRule() const { return m_winRule; }
+    GameState state() const { return m_state; }
+    uint64_t seed() const { return m_seed; }
+
+    bool isValid(int row, int col) const {
+        return m_endless || (row >= 0 && row < m_rows && col >= 0 && col < m_cols);
+    }
+    // 格子的位元 (CellBits)；還沒碰過的區塊回傳 0 (沒打開的格子)，不會配置記憶體
+    uint8_t cell(int row, int col) const;
+    int value(int row, int col) const;  // -1 代表地雷，其餘為周圍地雷數 (只有打開過的格子才有意義)
+
+    // 上一個動作改變過的格子
+    const std::vector<Position> &changedCells() const { return changed; }
+
+    size_t tileCount() const { return tiles.size(); }  // 已經配置的區塊數
+    size_t storedTileCount() const { return m_storedTileCount; }  // 壓縮起來的區塊數 (含暫存檔)
+    size_t memoryUsage() const;  // 區塊大約用了多少 byte (不含暫存檔)
+    int64_t tileMineCount(int tileRow, int tileCol) const;  // 這個區塊有幾個地雷
+
+private:
+    struct Tile {
+        uint8_t cells[tileSize * tileSize] = {};
+        bool counted = false;  // 周圍地雷數算好了沒 (需要周圍 8 個區塊的地雷)
+    };
+
+    // 一區 (regionSize x regionSize 個區塊) 裡存起來的東西，key 都是區塊的 keyOf
+    struct StoredRegion {
+        // 壓縮起來的區塊：每個 byte 是 (打開/旗子的位元 << 6) | (連續格數 - 1)
+        std::unordered_map<uint64_t, std::vector<uint8_t>> tiles;
+        // 範圍外等著展開的格子 (在區塊裡的位置 row * tileSize + col)
+        std::unordered_map<uint64_t, std::vector<uint16_t>> pending;
+        bool dirty = false;   // 讀進來之後改過，寫回暫存檔前要重寫一筆
+        bool onDisk = false;  // 暫存檔裡有這一區的資料
+        int64_t diskOffset = -1;    // 暫存檔裡最新的那一筆 (-1 代表沒有)，放得下就直接蓋過去
+        uint32_t diskCapacity = 0;  // 那一筆保留給資料的長度
+        bool empty() const { return tiles.empty() && pending.empty(); }
+    };
+    static constexpr int regionShift = 4;
+    static constexpr int swapBuckets = 4096;  // 暫存檔開頭雜湊表的大小 (每格是那一串最新一筆的位置)
+    static constexpr int64_t swapRecordHeader = 24;  // 每一筆前面的 key、上一筆、長度、保留的長度
+    static constexpr int64_t swapCompactBytes = 1 << 16;  // 沒用的空間至少這麼多才整理暫存檔
+
+    static uint64_t keyOf(int tileRow, int tileCol) { return (uint64_t(uint32_t(tileRow)) << 32) | uint32_t(tileCol); }
+    int tileRows() const { return (m_rows + tileSize - 1) >> tileShift; }
+    int tileCols() const { return (m_cols + tileSize - 1) >> tileShift; }
+    bool hasTile(int tileRow, int tileCol) const {
+        return m_endless || (tileRow >= 0 && tileCol >= 0 && tileRow < tileRows() && tileCol < tileCols());
+    }
+    int tileHeight(int tileRow) const { return m_endless ? tileSize : std::min(tileSize, m_rows - (tileRow << tileShift)); }
+    int tileWidth(int tileCol) const { return m_endless ? tileSize : std::min(tileSize, m_cols - (tileCol << tileShift)); }
+    bool isActive(int tileRow, int tileCol) const {
+        return std::abs(tileRow - activeRow) <= activeRadius && std::abs(tileCol - activeCol) <= activeRadius;
+    }
+
+    Tile *findTile(int tileRow, int tileCol) const;
+    Tile *tileWithMines(int tileRow, int tileCol);   // 沒有就建立並放地雷
+    Tile *tileWithCounts(int tileRow, int tileCol);  // 同上，再算好周圍地雷數
+    void placeMines(Tile *tile, int tileRow, int tileCol);  // 跳過第一下周圍 safeRadius 的格子
+    void protectFirstClick(int row, int col);  // 決定第一下周圍不放地雷的範圍，重放已經配置的區塊
+    void countTile(Tile *tile, int tileRow, int tileCol);
+    uint8_t &cellRef(int row, int col);  // 呼叫前保證區塊已經算好數字
+    void clearTiles();
+    void openCell(uint8_t &cell, int row, int col);  // 打開一個安全的格子，空白格子放進 floodStack
+    void expandEmptyArea();
+    void checkWin();  // 同 MinesweeperBoard::checkWin (無限模式不檢查)
+    void moveActiveArea(int tileRow, int tileCol, int radius);
+    void storeTile(uint64_t key, const Tile *tile);
+    void restoreTile(uint64_t key, Tile *tile);
+    void addPending(int row, int col);
+    // 區塊所在的區：記憶體裡沒有就從暫存檔讀，暫存檔也沒有時 create 或有暫存檔才建立空的
+    StoredRegion *findRegion(int tileRow, int tileCol, bool create);
+    void trimRegions();  // 丟掉空的區，超過上限時把範圍外的區寫到暫存檔
+    bool writeRegion(uint64_t key, StoredRegion &region);
+    bool readRegion(uint64_t key, StoredRegion &region);
+    bool compactSwapFile();  // 只留每一區最新的一筆，重寫整個暫存檔
+    bool resetSwapFile();
+    static size_t regionBytes(const StoredRegion &region);
+
+    bool m_endless = false;
+    int endlessTileMines = 0;  // 無限模式每個區塊的地雷數
+    int m_rows = 0;
+    int m_cols = 0;
+    int64_t m_mineCount = 0;
+    int64_t m_flagCount = 0;
+    int64_t m_correctCount = 0;
+    int64_t m_revealedCount = 0;
+    GameState m_state = GameState::Playing;
+    WinRule m_winRule = WinRule::Either;
+    uint64_t m_seed = 0;
+    int safeRow = 0;  // 第一下的位置，周圍 safeRadius 格不放地雷 (-1 代表還沒點)
+    int safeCol = 0;
+    int safeRadius = -1;
+
+    std::unordered_map<uint64_t, std::unique_ptr<Tile>> tiles;
+    uint64_t lastKey = ~0ull;     // 上一次查到的區塊 (展開時幾乎都在同一塊)
+    Tile *lastTile = nullptr;
+    std::vector<Position> changed;
+    std::vector<Position> floodStack;
+
+    int activeRow = 0;  // 活動範圍中心的區塊
+    int activeCol = 0;
+    int activeRadius = defaultRadius;
+    std::unordered_map<uint64_t, StoredRegion> regions;  // 在記憶體裡的區 (key 是區的座標)
+    size_t m_storedTileCount = 0;
+    std::string swapPath;
+    std::fstream swapFile;
+    size_t swapLimit = 0;
+    bool swapUsed = false;  // 暫存檔寫過區 (找不到的區要去檔案裡找)
+    int64_t swapEnd = 0;    // 暫存檔的長度 (下一筆接在這裡)
+    int64_t swapDead = 0;   // 被新的一筆取代掉、沒用的空間
+};
+
+#endif // CHUNKEDBOARD_H
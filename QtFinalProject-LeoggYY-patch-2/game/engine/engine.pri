@@ -0,0 +1,14 @@
+﻿# 連結遊戲邏輯的靜態函式庫 (engine.pro)
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+CONFIG += thread  # ProbabilityEngine、NoGuessGenerator 用 std::thread
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../engine/release/ -lengine
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../engine/debug/ -lengine
+else:unix: LIBS += -L$$OUT_PWD/../engine/ -lengine
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../engine/release/libengine.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../engine/debug/libengine.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../engine/release/engine.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../engine/debug/engine.lib
+else:unix: PRE_TARGETDEPS += $$OUT_PWD/../engine/libengine.a
@@ -0,0 +1,28 @@
+﻿TEMPLATE = lib
+CONFIG += staticlib c++17
+CONFIG -= qt
+
+TARGET = engine
+
+SOURCES += \
+    bitboard.cpp \
+    chunkedboard.cpp \
+    minesweeperboard.cpp \
+    movejournal.cpp \
+    noguessgenerator.cpp \
+    probabilityengine.cpp \
+    replay.cpp \
+    solver.cpp \
+    threebv.cpp
+
+HEADERS += \
+    bitboard.h \
+    chunkedboard.h \
+    gamerandom.h \
+    minesweeperboard.h \
+    movejournal.h \
+    noguessgenerator.h \
+    probabilityengine.h \
+    replay.h \
+    solver.h \
+    threebv.h
@@ -0,0 +1,56 @@
+﻿#ifndef GAMERANDOM_H
+#define GAMERANDOM_H
+
+#include <cstdint>
+
+// 可以指定種子的亂數產生器 (xoshiro256**)
+// 不用 std::uniform_int_distribution，因為它在不同編譯器上的結果不一樣，
+// 同一個種子在任何平台都要產生同一個盤面。
+class GameRandom
+{
+public:
+    explicit GameRandom(uint64_t seed = 0) { setSeed(seed); }
+
+    void setSeed(uint64_t seed) {
+        // 用 splitmix64 把一個種子展開成 4 個狀態
+        for (uint64_t &word : s) {
+            word = splitMix64(seed);
+        }
+    }
+
+    uint64_t next() {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // 回傳 [0, bound) 之間均勻分布的整數
+    uint64_t bounded(uint64_t bound) {
+        const uint64_t threshold = (0 - bound) % bound;  // 丟掉會造成偏差的最小那一段
+        for (;;) {
+            uint64_t r = next();
+            if (r >= threshold) return r % bound;
+        }
+    }
+
+    // 把 seed 往前推並回傳下一個打散過的值
+    static uint64_t splitMix64(uint64_t &seed) {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t s[4];
+};
+
+#endif // GAMERANDOM_H
@@ -0,0 +1,438 @@
+﻿#include "minesweeperboard.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+
+static_assert(MinesweeperBoard::MineBit == 1 << 4, "countByBoxFilter 用 >> 4 取出地雷位元");
+
+namespace {
+uint64_t load64(const uint8_t *p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+void store64(uint8_t *p, uint64_t v) {
+    std::memcpy(p, &v, sizeof(v));
+}
+
+// 8 個格子的地雷位元，各自放在自己那個 byte 的最低位
+uint64_t mineLanes(uint64_t cells8) {
+    return (cells8 >> 4) & 0x0101010101010101ULL;
+}
+} // namespace
+
+MinesweeperBoard::MinesweeperBoard(int rows, int cols, int mineCount)
+{
+    resize(rows, cols, mineCount);
+}
+
+void MinesweeperBoard::resize(int rows, int cols, int mineCount) {
+    m_rows = std::max(rows, 0);
+    m_cols = std::max(cols, 0);
+    m_mineCount = std::clamp(mineCount, 0, m_rows * m_cols);
+    stride = m_cols + 2;
+
+    const int offsets[8] = {
+        -stride - 1, -stride, -stride + 1,
+        -1, 1,
+        stride - 1, stride, stride + 1
+    };
+    std::copy(offsets, offsets + 8, neighbours);
+
+    cells.assign(size_t(m_rows + 2) * stride, 0);
+    clear();
+}
+
+void MinesweeperBoard::clear() {
+    m_pendingGeneration = false;
+    m_flagCount = 0;
+    m_correctCount = 0;
+    m_revealedCount = 0;
+    m_state = GameState::Playing;
+    changed.clear();
+
+    // 記下跟全新盤面看起來不一樣的格子 (打開過或插了旗子)，畫面只要重畫這些。
+    // 一次檢查 8 個格子，整段都沒動過就直接跳過
+    const uint64_t touchedLanes = 0x0101010101010101ULL * (RevealedBit | FlagBit);
+    for (int i = 0; i < m_rows; ++i) {
+        const int rowStart = index(i, 0);
+        const int rowEnd = rowStart + m_cols;
+        int idx = rowStart;
+        for (; idx + 8 <= rowEnd; idx += 8) {
+            if (!(load64(cells.data() + idx) & touchedLanes)) continue;
+            for (int k = idx; k < idx + 8; ++k) {
+                if (cells[k] & (RevealedBit | FlagBit)) changed.push_back(k);
+            }
+        }
+        for (; idx < rowEnd; ++idx) {
+            if (cells[idx] & (RevealedBit | FlagBit)) changed.push_back(idx);
+        }
+    }
+
+    std::memset(cells.data(), 0, cells.size());
+    markBorder();
+}
+
+void MinesweeperBoard::markBorder() {
+    // 外圍一圈標成邊框
+    const uint8_t border = BorderBit | RevealedBit;
+    std::fill(cells.begin(), cells.begin() + stride, border);
+    std::fill(cells.end() - stride, cells.end(), border);
+    for (int i = 1; i <= m_rows; ++i) {
+        cells[size_t(i) * stride] = border;
+        cells[size_t(i) * stride + stride - 1] = border;
+    }
+}
+
+void MinesweeperBoard::initializeGame() {
+    std::random_device device;
+    initializeGame((uint64_t(device()) << 32) | device());
+}
+
+void MinesweeperBoard::initializeGame(uint64_t seed) {
+    generate(seed, nullptr, 0);
+}
+
+void MinesweeperBoard::prepareGame() {
+    std::random_device device;
+    prepareGame((uint64_t(device()) << 32) | device());
+}
+
+void MinesweeperBoard::prepareGame(uint64_t seed) {
+    m_seed = seed;
+    m_pendingGeneration = true;
+}
+
+void MinesweeperBoard::initializeGame(uint64_t seed, int safeRow, int safeCol) {
+    // 要避開的格子 (0 ~ rows*cols-1 的編號)，由小到大排好
+    int excluded[9];
+    int excludedCount = 0;
+    if (isValid(safeRow, safeCol)) {
+        for (int i = safeRow - 1; i <= safeRow + 1; ++i) {
+            for (int j = safeCol - 1; j <= safeCol + 1; ++j) {
+                if (isValid(i, j)) excluded[excludedCount++] = i * m_cols + j;
+            }
+        }
+        if (m_mineCount > m_rows * m_cols - excludedCount) { // 放不下：只避開那一格
+            excluded[0] = safeRow * m_cols + safeCol;
+            excludedCount = m_mineCount < m_rows * m_cols ? 1 : 0;
+        }
+    }
+    generate(seed, excluded, excludedCount);
+}
+
+void MinesweeperBoard::generate(uint64_t seed, const int *excluded, int excludedCount) {
+    m_pendingGeneration = false;
+    m_seed = seed;
+    rng.setSeed(seed);
+
+    // 計算每個格子 (包含地雷本身) 的周圍地雷數
+    if (effectiveCountStrategy() == CountStrategy::Scatter) {
+        mineScratch.clear();
+        placeMines(&mineScratch, excluded, excludedCount);
+        countByScatter(mineScratch);
+    } else {
+        placeMines(nullptr, excluded, excludedCount);
+        countByBoxFilter();
+    }
+}
+
+MinesweeperBoard::CountStrategy MinesweeperBoard::effectiveCountStrategy() const {
+    if (m_countStrategy != CountStrategy::Auto) return m_countStrategy;
+    // 每個地雷要隨機寫 8 個鄰居，點陣加總則是每 8 個格子固定幾個運算；
+    // 量測結果大約在地雷密度 3% 左右交叉 (見 bench)
+    return int64_t(m_mineCount) * 32 < int64_t(m_rows) * m_cols ? CountStrategy::Scatter
+                                                                 : CountStrategy::BoxFilter;
+}
+
+void MinesweeperBoard::placeMines(std::vector<int> *placed, const int *excluded, int excludedCount) {
+    // Floyd 演算法：從 n 個格子裡均勻取出 mineCount 個，每個地雷只抽一次亂數，
+    // 不會因為抽到重複的格子而重抽 (地雷很密的時候重抽的次數會爆炸)
+    // 要避開的格子直接從編號裡拿掉：第 t 個可以放的格子，跳過它前面被避開的格子
+    auto cellAt = [&](int t) {
+        for (int k = 0; k < excludedCount && excluded[k] <= t; ++k) ++t;
+        return index(t / m_cols, t % m_cols);
+    };
+    const int n = m_rows * m_cols - excludedCount;
+    for (int j = n - m_mineCount; j < n; ++j) {
+        int idx = cellAt(int(rng.bounded(uint64_t(j) + 1)));
+        if (cells[idx] & MineBit) { // 已經是地雷，改放在第 j 格 (第 j 格一定還沒放過)
+            idx = cellAt(j);
+        }
+        cells[idx] |= MineBit;
+        if (placed) placed->push_back(idx);
+    }
+}
+
+void MinesweeperBoard::countByScatter(const std::vector<int> &mines) {
+    // 周圍地雷數最多是 8，直接對整個 byte 加一只會動到 CountMask 的部分
+    for (int idx : mines) {
+        for (int k = 0; k < 8; ++k) {
+            ++cells[idx + neighbours[k]];
+        }
+    }
+    markBorder();  // 邊框格子也被加過，重設回來
+}
+
+void MinesweeperBoard::countByBoxFilter() {
+    // 先算每一列的水平三格加總，再把上中下三列加起來扣掉自己。
+    // 一次處理 8 個格子 (一個 uint64_t 裡的 8 個 byte)，每個 byte 最多加到 9，不會進位到隔壁
+    const int cols = m_cols;
+    const size_t width = size_t(stride);
+    uint8_t *base = cells.data();
+
+    rowSumScratch.assign(3 * width, 0);
+    uint8_t *above = rowSumScratch.data();
+    uint8_t *current = above + width;
+    uint8_t *below = current + width;
+
+    auto horizontalSum = [cols](const uint8_t *row, uint8_t *out) {
+        int j = 1;
+        for (; j + 8 <= cols + 1; j += 8) {
+            store64(out + j, mineLanes(load64(row + j - 1)) + mineLanes(load64(row + j)) + mineLanes(load64(row + j + 1)));
+        }
+        for (; j <= cols; ++j) {
+            out[j] = uint8_t(((row[j - 1] >> 4) & 1) + ((row[j] >> 4) & 1) + ((row[j + 1] >> 4) & 1));
+        }
+    };
+
+    horizontalSum(base + width, current);  // 第 0 列是邊框，above 保持 0
+    for (int i = 1; i <= m_rows; ++i) {
+        uint8_t *row = base + size_t(i) * width;
+        horizontalSum(row + width, below);  // 最後一次讀到的是下邊框，加總會是 0
+        int j = 1;
+        for (; j + 8 <= cols + 1; j += 8) {
+            // 中間那列的加總包含自己，所以減掉自己不會借位
+            uint64_t self = load64(row + j);
+            uint64_t sum = load64(above + j) + load64(current + j) + load64(below + j) - mineLanes(self);
+            store64(row + j, self | sum);
+        }
+        for (; j <= cols; ++j) {
+            row[j] = uint8_t(row[j] | (above[j] + current[j] + below[j] - ((row[j] >> 4) & 1)));
+        }
+        std::swap(above, current);
+        std::swap(current, below);
+    }
+}
+
+bool MinesweeperBoard::isValid(int row, int col) const {
+    return row >= 0 && row < m_rows && col >= 0 && col < m_cols;
+}
+
+int MinesweeperBoard::value(int row, int col) const {
+    uint8_t c = cells[index(row, col)];
+    return (c & MineBit) ? -1 : (c & CountMask);
+}
+
+MinesweeperBoard::CellState MinesweeperBoard::stateOf(uint8_t cell) {
+    if (cell & RevealedBit) return (cell & MineBit) ? CellState::Exploded : CellState::Revealed;
+    return (cell & FlagBit) ? CellState::Flagged : CellState::Covered;
+}
+
+MinesweeperBoard::RevealResult MinesweeperBoard::reveal(int row, int col) {
+    if (!isValid(row, col)) {
+        changed.clear();
+        return RevealResult::Ignored;
+    }
+    return revealAt(index(row, col));
+}
+
+MinesweeperBoard::RevealResult MinesweeperBoard::revealAt(int idx) {
+    changed.clear();
+    m_floodFillNanos = 0;
+    if (m_state != GameState::Playing) return RevealResult::Ignored;
+    if (cells[idx] & (RevealedBit | FlagBit)) return RevealResult::Ignored; // 已經打開或插了旗子
+
+    if (m_pendingGeneration) { // 第一下：現在才放地雷，避開這一格和周圍 8 格
+        initializeGame(m_seed, rowOf(idx), colOf(idx));
+        if (m_flagCount > 0) recountCorrectFlags();
+    }
+
+    if (cells[idx] & MineBit) { // 點到地雷
+        cells[idx] |= RevealedBit;
+        changed.push_back(idx);
+        m_state = GameState::Lost;
+        return RevealResult::Exploded;
+    }
+
+    if (cells[idx] & CountMask) { // 點到數字
+        cells[idx] |= RevealedBit;
+        changed.push_back(idx);
+    } else if (!m_timingEnabled) { // 點到空白
+        expandEmptyArea(idx);
+    } else {
+        auto start = std::chrono::steady_clock::now();
+        expandEmptyArea(idx);
+        m_floodFillNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start).count();
+    }
+    m_revealedCount += int(changed.size());  // 打開的都不是地雷
+    checkWin();
+    return RevealResult::Opened;
+}
+
+void MinesweeperBoard::expandEmptyArea(int index) {
+    // 格子在放進堆疊時就標成已打開，所以每個格子最多只會被放進去一次；
+    // 已打開的位元同時就是 visited，邊框格子本來就是已打開，不用檢查範圍。
+    // floodStack 在每一步之間重複使用，不會每次都重新配置記憶體
+    cells[index] |= RevealedBit;
+    changed.push_back(index);
+    floodStack.clear();
+    floodStack.push_back(index);
+    expandFloodStack();
+}
+
+void MinesweeperBoard::expandFloodStack() {
+    while (!floodStack.empty()) {
+        int idx = floodStack.back();
+        floodStack.pop_back();
+
+        for (int k = 0; k < 8; ++k) {
+            int next = idx + neighbours[k];
+            if (cells[next] & (RevealedBit | FlagBit)) continue;
+
+            cells[next] |= RevealedBit;
+            changed.push_back(next);
+            if ((cells[next] & CountMask) == 0) {
+                floodStack.push_back(next);  // 空白格子繼續往外展開，數字格子只打開
+            }
+        }
+    }
+}
+
+void MinesweeperBoard::restoreCells(const int *indices, const uint8_t *bits, int count, GameState state) {
+    changed.clear();
+    for (int k = 0; k < count; ++k) {
+        const int idx = indices[k];
+        const uint8_t old = cells[idx];
+        const uint8_t now = (old & ~(RevealedBit | FlagBit)) | (bits[k] & (RevealedBit | FlagBit));
+        if (now == old) continue;
+
+        if ((old ^ now) & FlagBit) {
+            int delta = (now & FlagBit) ? 1 : -1;
+            m_flagCount += delta;
+            if (now & MineBit) m_correctCount += delta;
+        }
+        if (((old ^ now) & RevealedBit) && !(now & MineBit)) m_revealedCount += (now & RevealedBit) ? 1 : -1;
+        cells[idx] = now;
+        changed.push_back(idx);
+    }
+    m_state = state;
+}
+
+MinesweeperBoard::RevealResult MinesweeperBoard::chord(int row, int col) {
+    if (!isValid(row, col)) {
+        changed.clear();
+        return RevealResult::Ignored;
+    }
+    return chordAt(index(row, col));
+}
+
+MinesweeperBoard::RevealResult MinesweeperBoard::chordAt(int idx) {
+    changed.clear();
+    m_floodFillNanos = 0;
+    if (m_state != GameState::Playing) return RevealResult::Ignored;
+    const uint8_t c = cells[idx];
+    if ((c & (RevealedBit | MineBit | BorderBit)) != RevealedBit || !(c & CountMask)) return RevealResult::Ignored;  // 只有打開的數字可以
+
+    int flags = 0;
+    for (int k = 0; k < 8; ++k) {
+        if (cells[idx + neighbours[k]] & FlagBit) ++flags;
+    }
+    if (flags != (c & CountMask)) return RevealResult::Ignored;
+
+    const auto start = m_timingEnabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    // 周圍的格子全部先打開，空白的一起放進 floodStack，只跑一次展開 (多個起點)
+    int exploded = 0;
+    floodStack.clear();
+    for (int k = 0; k < 8; ++k) {
+        int next = idx + neighbours[k];
+        if (cells[next] & (RevealedBit | FlagBit)) continue;
+
+        cells[next] |= RevealedBit;
+        changed.push_back(next);
+        if (cells[next] & MineBit) {
+            ++exploded;
+        } else if ((cells[next] & CountMask) == 0) {
+            floodStack.push_back(next);
+        }
+    }
+    expandFloodStack();
+    if (m_timingEnabled) {
+        m_floodFillNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start).count();
+    }
+
+    m_revealedCount += int(changed.size()) - exploded;
+    if (exploded > 0) {
+        m_state = GameState::Lost;
+        return RevealResult::Exploded;
+    }
+    checkWin();
+    return changed.empty() ? RevealResult::Ignored : RevealResult::Opened;
+}
+
+MinesweeperBoard::FlagResult MinesweeperBoard::toggleFlag(int row, int col) {
+    if (!isValid(row, col)) {
+        changed.clear();
+        return FlagResult::Ignored;
+    }
+    return toggleFlagAt(index(row, col));
+}
+
+MinesweeperBoard::FlagResult MinesweeperBoard::toggleFlagAt(int idx) {
+    changed.clear();
+    if (m_state != GameState::Playing || (cells[idx] & RevealedBit)) return FlagResult::Ignored;
+
+    cells[idx] ^= FlagBit;
+    bool placed = cells[idx] & FlagBit;
+    changed.push_back(idx);
+
+    int delta = placed ? 1 : -1;
+    m_flagCount += delta;
+    if (cells[idx] & MineBit) {
+        m_correctCount += delta;
+    }
+    checkWin();
+    return placed ? FlagResult::Placed : FlagResult::Removed;
+}
+
+void MinesweeperBoard::checkWin() {
+    bool flagsDone = m_mineCount == m_correctCount && m_mineCount == m_flagCount;  // 旗子剛好插在地雷上
+    bool revealDone = m_revealedCount == safeCount();  // 安全的格子都打開了
+    if ((m_winRule != WinRule::RevealSafe && flagsDone) || (m_winRule != WinRule::FlagMines && revealDone))
+        m_state = GameState::Won;
+}
+
+void MinesweeperBoard::recountCorrectFlags() {
+    m_correctCount = 0;
+    for (int i = 0; i < m_rows; ++i) {
+        int idx = index(i, 0);
+        for (int j = 0; j < m_cols; ++j, ++idx) {
+            if ((cells[idx] & (FlagBit | MineBit)) == (FlagBit | MineBit)) ++m_correctCount;
+        }
+    }
+}
+
+void MinesweeperBoard::revealAllBombs() {
+    if (m_pendingGeneration) { // 還沒點過：直接產生一個盤面來顯示
+        initializeGame(m_seed);
+        recountCorrectFlags();
+    }
+    changed.clear();
+    for (int i = 0; i < m_rows; ++i) {
+        int idx = index(i, 0);
+        for (int j = 0; j < m_cols; ++j, ++idx) {
+            if (!(cells[idx] & RevealedBit)) {
+                cells[idx] |= RevealedBit;
+                changed.push_back(idx);
+                if (!(cells[idx] & MineBit)) ++m_revealedCount;
+            }
+        }
+    }
+    if (m_state == GameState::Playing)
+        m_state = GameState::Lost;
+}
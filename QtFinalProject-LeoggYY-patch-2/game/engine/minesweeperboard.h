@@ -0,0 +1,148 @@
+﻿#ifndef MINESWEEPERBOARD_H
+#define MINESWEEPERBOARD_H
+
+#include <cstdint>
+#include <vector>
+#include "gamerandom.h"
+
+// 踩地雷的遊戲邏輯 (不依賴 Qt，可以在沒有視窗的情況下跑模擬與效能測試)
+//
+// 盤面存成一條連續的 byte 陣列，外面多包一圈邊框格子，
+// 所以走訪鄰居時不用檢查邊界：index(row, col) + neighbourOffsets[k]
+class MinesweeperBoard
+{
+public:
+    enum class RevealResult { Ignored, Opened, Exploded };  // reveal 的結果
+    enum class FlagResult { Ignored, Placed, Removed };     // toggleFlag 的結果
+    enum class GameState { Playing, Won, Lost };
+
+    // 怎樣算贏 (每一步只比較計數器，O(1))
+    enum class WinRule {
+        FlagMines,   // 旗子剛好插在所有地雷上，沒有多餘的旗子
+        RevealSafe,  // 所有不是地雷的格子都打開了
+        Either       // 兩種都算 (預設)
+    };
+
+    // 格子的狀態 (由 CellBits 決定)：
+    // Covered <-> Flagged (toggleFlag)，Covered -> Revealed (reveal)，地雷 Covered -> Exploded
+    enum class CellState { Covered, Flagged, Revealed, Exploded };
+
+    // 計算周圍地雷數的方法
+    enum class CountStrategy {
+        Auto,      // 依照地雷密度自動選擇
+        Scatter,   // 每個地雷把 8 個鄰居加一 (地雷稀疏時最快)
+        BoxFilter  // 逐列對地雷點陣做 3x3 加總 (地雷密集時最快，迴圈可以被向量化)
+    };
+
+    // 每個格子一個 byte
+    enum CellBits : uint8_t {
+        CountMask = 0x0F,    // 周圍地雷數 (0~8)
+        MineBit = 0x10,      // 地雷
+        RevealedBit = 0x20,  // 已經打開
+        FlagBit = 0x40,      // 插了旗子
+        BorderBit = 0x80     // 外圍的邊框格子 (同時標成已打開，展開時會自動停下)
+    };
+
+    MinesweeperBoard(int rows = 10, int cols = 10, int mineCount = 10);
+
+    void resize(int rows, int cols, int mineCount);  // 改變大小並清空盤面
+    void clear();  // 清空盤面 (保留大小)，changedCells() 會是原本打開過或插過旗子的格子
+    void initializeGame();  // 用新的隨機種子放置地雷並計算數字
+    void initializeGame(uint64_t seed);  // 同一個種子一定產生同一個盤面
+    // 同上，但 (safeRow, safeCol) 和周圍 8 格不放地雷 (地雷太多放不下時只保留那一格)
+    void initializeGame(uint64_t seed, int safeRow, int safeCol);
+    // 先不放地雷，等到第一次 reveal 才用那一格當 safeRow/safeCol 產生盤面 (第一下一定不會踩到地雷)
+    void prepareGame();
+    void prepareGame(uint64_t seed);
+    bool minesPlaced() const { return !m_pendingGeneration; }
+    uint64_t seed() const { return m_seed; }  // 目前盤面用的種子
+
+    void setCountStrategy(CountStrategy strategy) { m_countStrategy = strategy; }
+    CountStrategy countStrategy() const { return m_countStrategy; }
+    CountStrategy effectiveCountStrategy() const;  // Auto 實際會選到哪一個
+
+    void setWinRule(WinRule rule) { m_winRule = rule; }
+    WinRule winRule() const { return m_winRule; }
+
+    RevealResult reveal(int row, int col);  // 打開格子
+    FlagResult toggleFlag(int row, int col);  // 放置/移除旗子
+    RevealResult revealAt(int index);  // 同 reveal，但直接用 index (呼叫端保證是盤面內的格子)
+    FlagResult toggleFlagAt(int index);  // 同 toggleFlag，但直接用 index
+    // 快速打開 (chord)：打開的數字周圍插的旗子數剛好等於數字時，一次打開周圍所有沒插旗子的格子；
+    // 碰到的空白區域一起展開，所有打開的格子都在同一批 changedCells 裡。旗子插錯就會踩到地雷
+    RevealResult chord(int row, int col);
+    RevealResult chordAt(int index);
+    void revealAllBombs();  // 打開所有格子
+    // 悔棋 (MoveJournal) 用：indices[k] 的 RevealedBit/FlagBit 改成 bits[k] 裡的值 (地雷和數字不動)，
+    // 計數器跟著調整，遊戲狀態改成 state；changedCells() 會是這些格子
+    void restoreCells(const int *indices, const uint8_t *bits, int count, GameState state);
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int mineCount() const { return m_mineCount; }
+    int flagCount() const { return m_flagCount; }
+    int correctCount() const { return m_correctCount; }  // 插在地雷上的旗子數
+    int revealedCount() const { return m_revealedCount; }  // 打開的安全格子數
+    int safeCount() const { return m_rows * m_cols - m_mineCount; }  // 不是地雷的格子數
+    GameState state() const { return m_state; }
+
+    bool isValid(int row, int col) const;  // 檢查格子是否有效
+    bool isMine(int row, int col) const { return cells[index(row, col)] & MineBit; }
+    bool isRevealed(int row, int col) const { return cells[index(row, col)] & RevealedBit; }
+    bool isFlagged(int row, int col) const { return cells[index(row, col)] & FlagBit; }
+    int value(int row, int col) const;  // -1 代表地雷，其餘為周圍地雷數
+
+    // 格子在陣列裡的位置 (含邊框)
+    int index(int row, int col) const { return (row + 1) * stride + col + 1; }
+    int rowOf(int index) const { return index / stride - 1; }
+    int colOf(int index) const { return index % stride - 1; }
+    uint8_t cell(int index) const { return cells[index]; }
+    static CellState stateOf(uint8_t cell);
+    CellState cellState(int index) const { return stateOf(cells[index]); }
+    int paddedSize() const { return int(cells.size()); }  // 含邊框的格子總數 (index 的範圍)
+    const int *neighbourOffsets() const { return neighbours; }  // 8 個鄰居的位移
+
+    // 上一個動作改變過的格子 (index)，畫面只需要更新這些格子
+    const std::vector<int> &changedCells() const { return changed; }
+
+    // 效能量測：開啟後 reveal 會記錄展開空白區域花的時間 (奈秒)
+    void setTimingEnabled(bool enabled) { m_timingEnabled = enabled; }
+    int64_t lastFloodFillNanos() const { return m_floodFillNanos; }
+
+private:
+    void markBorder();  // 把外圍一圈設成邊框格子
+    void generate(uint64_t seed, const int *excluded, int excludedCount);  // 放地雷並計算數字，excluded 由小到大
+    void placeMines(std::vector<int> *placed, const int *excluded, int excludedCount);  // 放置地雷 (Floyd 取樣，O(mineCount))
+    void countByScatter(const std::vector<int> &mines);
+    void countByBoxFilter();
+    void expandEmptyArea(int index);  // 展開空白區域
+    void expandFloodStack();  // 從 floodStack 裡的空白格子繼續展開
+    void checkWin();  // 依照 WinRule 比較計數器
+    void recountCorrectFlags();  // 插旗子之後才放地雷時，重新計算插對的旗子
+
+    int m_rows;
+    int m_cols;
+    int m_mineCount;
+    int m_flagCount = 0;
+    int m_correctCount = 0;
+    int m_revealedCount = 0;
+    GameState m_state = GameState::Playing;
+    WinRule m_winRule = WinRule::Either;
+
+    int stride = 0;        // 一列的長度 (cols + 2)
+    int neighbours[8];     // 8 個鄰居相對於自己的位移
+    std::vector<uint8_t> cells;  // (rows + 2) * (cols + 2) 個格子
+    std::vector<int> changed;
+    std::vector<int> floodStack;        // expandEmptyArea 用的堆疊
+    std::vector<int> mineScratch;       // Scatter 用：這次放的地雷位置
+    std::vector<uint8_t> rowSumScratch; // BoxFilter 用：三列的水平加總
+
+    CountStrategy m_countStrategy = CountStrategy::Auto;
+    bool m_timingEnabled = false;
+    int64_t m_floodFillNanos = 0;
+    uint64_t m_seed = 0;
+    bool m_pendingGeneration = false;  // prepareGame 之後、第一次 reveal 之前
+    GameRandom rng;
+};
+
+#endif // MINESWEEPERBOARD_H
@@ -0,0 +1,95 @@
+﻿#include "movejournal.h"
+
+using Cell = MinesweeperBoard::CellBits;
+
+MoveJournal::MoveJournal(size_t memoryLimit)
+    : m_memoryLimit(memoryLimit)
+{
+}
+
+void MoveJournal::setMemoryLimit(size_t bytes) {
+    m_memoryLimit = bytes;
+    evict();
+}
+
+void MoveJournal::clear() {
+    actions.clear();
+    indices.clear();
+    before.clear();
+    after.clear();
+    first = 0;
+    current = 0;
+}
+
+void MoveJournal::record(const MinesweeperBoard &board, GameState stateBefore) {
+    if (board.changedCells().empty()) return;
+    if (canRedo()) { // 走了新的一步，原本可以 redo 的就沒了
+        const size_t cut = actions[current].begin;
+        indices.resize(cut);
+        before.resize(cut);
+        after.resize(cut);
+        actions.resize(current);
+    }
+    actions.push_back({ indices.size(), stateBefore, board.state() });
+    ++current;
+    appendCells(board);
+    evict();
+}
+
+void MoveJournal::append(const MinesweeperBoard &board) {
+    if (!canUndo() || canRedo()) return;
+    appendCells(board);
+    actions.back().stateAfter = board.state();
+    evict();
+}
+
+void MoveJournal::appendCells(const MinesweeperBoard &board) {
+    for (int idx : board.changedCells()) {
+        const uint8_t now = board.cell(idx);
+        indices.push_back(idx);
+        after.push_back(now);
+        before.push_back((now & Cell::RevealedBit) ? uint8_t(now & ~Cell::RevealedBit) : uint8_t(now ^ Cell::FlagBit));
+    }
+}
+
+bool MoveJournal::undo(MinesweeperBoard &board) {
+    if (!canUndo()) return false;
+    --current;
+    const Action &action = actions[current];
+    const size_t begin = action.begin;
+    board.restoreCells(indices.data() + begin, before.data() + begin, int(endOf(current) - begin), action.stateBefore);
+    return true;
+}
+
+bool MoveJournal::redo(MinesweeperBoard &board) {
+    if (!canRedo()) return false;
+    const Action &action = actions[current];
+    const size_t begin = action.begin;
+    board.restoreCells(indices.data() + begin, after.data() + begin, int(endOf(current) - begin), action.stateAfter);
+    ++current;
+    return true;
+}
+
+size_t MoveJournal::memoryUsage() const {
+    const size_t cells = indices.size() - (first < actions.size() ? actions[first].begin : indices.size());
+    return cells * (sizeof(int) + 2 * sizeof(uint8_t)) + (actions.size() - first) * sizeof(Action);
+}
+
+void MoveJournal::evict() {
+    // 最新的一步一定留著；被丟掉的步驟如果還可以 redo，redo 也跟著沒了
+    while (actions.size() - first > 1 && memoryUsage() > m_memoryLimit) {
+        ++first;
+        if (current < first) current = first;
+    }
+
+    // 丟掉的部分超過一半才真的搬移，平均下來每個格子只搬一次
+    if (first == 0 || first * 2 < actions.size()) return;
+    const size_t dropped = actions[first].begin;
+    indices.erase(indices.begin(), indices.begin() + dropped);
+    before.erase(before.begin(), before.begin() + dropped);
+    after.erase(after.begin(), after.begin() + dropped);
+    actions.erase(actions.begin(), actions.begin() + first);
+    for (Action &action : actions) action.begin -= dropped;
+    current -= first;
+    first = 0;
+}
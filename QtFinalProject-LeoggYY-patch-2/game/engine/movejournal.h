@@ -0,0 +1,65 @@
+﻿#ifndef MOVEJOURNAL_H
+#define MOVEJOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "minesweeperboard.h"
+
+// 悔棋 (undo/redo)：每一步只記下改變的格子 (index、之前和之後的 byte)，
+// 所有步驟接在同一組連續的陣列裡，悔一步的時間只跟那一步改變的格子數有關，跟盤面大小無關。
+// 記憶體超過上限時丟掉最舊的步驟。
+//
+// 之前的 byte 從之後的 byte 推回來：打開的格子之前一定還沒打開 (reveal、chord、revealAllBombs)，
+// 沒打開的格子就是插/拔旗子 (toggleFlag)。
+// 第一下才放地雷 (prepareGame) 的話，悔掉第一下之後地雷還是留在原本的位置。
+class MoveJournal
+{
+public:
+    using GameState = MinesweeperBoard::GameState;
+    static constexpr size_t defaultMemoryLimit = size_t(64) << 20;
+
+    explicit MoveJournal(size_t memoryLimit = defaultMemoryLimit);
+
+    // 最新的一步不會被丟掉，就算它自己就超過上限
+    void setMemoryLimit(size_t bytes);
+    size_t memoryLimit() const { return m_memoryLimit; }
+    void clear();
+
+    // 在動作之後呼叫：記下 board.changedCells()，stateBefore 是動作之前的遊戲狀態。
+    // 可以 redo 的步驟會被丟掉
+    void record(const MinesweeperBoard &board, GameState stateBefore);
+    // 同上，但併進上一步 (例如踩到地雷之後的 revealAllBombs，悔棋時一起還原)
+    void append(const MinesweeperBoard &board);
+
+    bool canUndo() const { return current > first; }
+    bool canRedo() const { return current < actions.size(); }
+    int undoCount() const { return int(current - first); }
+    int redoCount() const { return int(actions.size() - current); }
+    // 還原/重做一步，board.changedCells() 是這一步改變的格子；沒有可以做的回傳 false
+    bool undo(MinesweeperBoard &board);
+    bool redo(MinesweeperBoard &board);
+
+    size_t memoryUsage() const;  // 還留著的步驟佔用的 byte 數
+
+private:
+    struct Action {
+        size_t begin;  // 在 indices/before/after 裡從哪裡開始
+        GameState stateBefore;
+        GameState stateAfter;
+    };
+
+    size_t endOf(size_t action) const { return action + 1 < actions.size() ? actions[action + 1].begin : indices.size(); }
+    void appendCells(const MinesweeperBoard &board);
+    void evict();  // 超過上限就丟掉最舊的步驟
+
+    std::vector<Action> actions;
+    size_t first = 0;    // 還留著的最舊一步 (前面的已經丟掉，累積夠多才一次搬掉)
+    size_t current = 0;  // 下一個 redo 的步驟
+    std::vector<int> indices;
+    std::vector<uint8_t> before;
+    std::vector<uint8_t> after;
+    size_t m_memoryLimit;
+};
+
+#endif // MOVEJOURNAL_H
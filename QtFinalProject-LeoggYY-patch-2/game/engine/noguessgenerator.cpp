@@ -0,0 +1,186 @@
+﻿#include "noguessgenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+using GameState = MinesweeperBoard::GameState;
+
+NoGuessGenerator::NoGuessGenerator(int threadCount)
+{
+    if (threadCount <= 0) threadCount = int(std::thread::hardware_concurrency());
+    m_threadCount = std::max(threadCount, 1);
+    std::random_device device;
+    nextSeed = (uint64_t(device()) << 32) | device();
+}
+
+NoGuessGenerator::~NoGuessGenerator() {
+    stop();
+}
+
+void NoGuessGenerator::start(const std::vector<Config> &configs) {
+    addSlots(configs, false);
+}
+
+void NoGuessGenerator::request(const Config &config) {
+    addSlots({ config }, true);
+}
+
+void NoGuessGenerator::addSlots(const std::vector<Config> &configs, bool once) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const Config &config : configs) {
+            int slot = slotOf(config);
+            if (slot < 0) {
+                slots.push_back(Slot{ config, false, Result(), once });
+            } else if (!once) {
+                slots[slot].once = false;  // 之前只要一個的設定改成一直準備
+            }
+        }
+        stopping = false;
+    }
+    wake.notify_all();
+
+    if (threads.empty()) {
+        for (int i = 0; i < m_threadCount; ++i) {
+            threads.emplace_back(&NoGuessGenerator::work, this, i);
+        }
+    }
+}
+
+void NoGuessGenerator::cancel(const Config &config) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        int slot = slotOf(config);
+        if (slot < 0 || !slots[slot].once) return;
+        slots.erase(slots.begin() + slot);
+    }
+    found.notify_all();  // 正在 take 等這個設定的人不用再等
+}
+
+void NoGuessGenerator::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    found.notify_all();
+    for (std::thread &thread : threads) thread.join();
+    threads.clear();
+}
+
+bool NoGuessGenerator::take(const Config &config, Result *result, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (slotOf(config) < 0) return false;
+    // 等的時候別人可能拿走只要一個的設定，位置會變，每次都重新找
+    found.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() {
+        int slot = slotOf(config);
+        return slot < 0 || slots[slot].ready || stopping;
+    });
+    int slot = slotOf(config);
+    if (slot < 0 || !slots[slot].ready) return false;
+
+    *result = slots[slot].result;
+    if (slots[slot].once) {
+        slots.erase(slots.begin() + slot);
+    } else {
+        slots[slot].ready = false;
+    }
+    lock.unlock();
+    wake.notify_all();  // 再準備下一個
+    return true;
+}
+
+int NoGuessGenerator::slotOf(const Config &config) const {
+    for (size_t i = 0; i < slots.size(); ++i) {
+        if (slots[i].config == config) return int(i);
+    }
+    return -1;
+}
+
+void NoGuessGenerator::work(int worker) {
+    // 每個執行緒有自己的盤面和 Solver，驗證時不用鎖
+    MinesweeperBoard board;
+    Solver solver;
+    size_t turn = size_t(worker);
+
+    for (;;) {
+        Config config;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // 還沒準備好的設定輪流做，所有人都準備好了就睡到有人拿走為止
+            auto pending = [&]() {
+                for (const Slot &slot : slots) {
+                    if (!slot.ready) return true;
+                }
+                return false;
+            };
+            wake.wait(lock, [&]() { return stopping || pending(); });
+            if (stopping) return;
+            do {
+                turn = (turn + 1) % slots.size();
+            } while (slots[turn].ready);
+            config = slots[turn].config;
+        }
+
+        if (board.rows() != config.rows || board.cols() != config.cols || board.mineCount() != config.mineCount) {
+            board.resize(config.rows, config.cols, config.mineCount);
+        }
+        // 一次試幾個候選盤面再回去看看有沒有別的事要做 (每試一個都看一下是不是要停了)
+        int attempt = 0;
+        bool filled = false;
+        for (; attempt < 16 && !stopping; ++attempt) {
+            uint64_t seed = nextSeed.fetch_add(1);
+            int startRow = config.rows / 2;
+            int startCol = config.cols / 2;
+            board.clear();
+            board.initializeGame(seed, startRow, startCol);
+            if (!verify(board, board.index(startRow, startCol), solver, &stopping)) continue;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            int slot = slotOf(config);
+            if (slot >= 0 && !slots[slot].ready) {
+                slots[slot].ready = true;
+                slots[slot].result = Result{ seed, startRow, startCol };
+                filled = true;
+                found.notify_all();
+            }
+            break;
+        }
+
+        // request 的設定試太多次還找不到就放棄 (例如地雷太密，幾乎不可能不用猜)
+        bool failed = false;
+        if (!filled && attempt > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            int slot = slotOf(config);
+            if (slot >= 0 && slots[slot].once && !slots[slot].ready) {
+                slots[slot].attempts += attempt;
+                if (slots[slot].attempts >= maxRequestAttempts) {
+                    slots.erase(slots.begin() + slot);
+                    failed = true;
+                    found.notify_all();
+                }
+            }
+        }
+        if ((filled || failed) && onFound) onFound(config, filled);  // 不能鎖著呼叫：callback 可能馬上 take
+    }
+}
+
+bool NoGuessGenerator::verify(MinesweeperBoard &board, int startIndex, Solver &solver, const std::atomic<bool> *cancel) {
+    solver.reset(&board);
+    board.revealAt(startIndex);
+    solver.update(board.changedCells());
+
+    std::vector<int> moves;
+    while (board.state() == GameState::Playing && solver.unknownCount() > 0) {
+        if (cancel && *cancel) return false;
+        solver.solve();
+        if (solver.safeCells().empty()) break;  // 推不出來：要猜
+        moves = solver.safeCells();
+        for (int idx : moves) {
+            board.revealAt(idx);
+            solver.update(board.changedCells());
+        }
+    }
+    // 打開所有安全的格子就贏了 (WinRule::RevealSafe)，這時候剩下的一定都是地雷
+    return board.state() == GameState::Won || (board.state() == GameState::Playing && solver.unknownCount() == 0);
+}
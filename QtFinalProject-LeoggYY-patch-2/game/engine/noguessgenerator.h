@@ -0,0 +1,84 @@
+﻿#ifndef NOGUESSGENERATOR_H
+#define NOGUESSGENERATOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "minesweeperboard.h"
+#include "solver.h"
+
+// 「不用猜」的盤面：從指定的起點開始，只靠推論 (Solver) 就能解開整個盤面。
+// 大部分隨機盤面都要猜，所以要產生很多候選盤面一個一個驗證；
+// 這件事在背景執行緒做，玩家還在選難度的時候就先準備好。
+class NoGuessGenerator
+{
+public:
+    struct Config {
+        int rows;
+        int cols;
+        int mineCount;
+        bool operator==(const Config &other) const {
+            return rows == other.rows && cols == other.cols && mineCount == other.mineCount;
+        }
+    };
+
+    // 找到的盤面：initializeGame(seed, startRow, startCol) 就能重建，從起點打開就不用猜
+    struct Result {
+        uint64_t seed = 0;
+        int startRow = 0;
+        int startCol = 0;
+    };
+
+    explicit NoGuessGenerator(int threadCount = 0);  // 0 代表用全部的核心
+    ~NoGuessGenerator();
+
+    // 開始 (或繼續) 在背景幫這些設定各準備一個盤面
+    void start(const std::vector<Config> &configs);
+    // 只要一個盤面 (例如自訂大小)：拿走之後就不再幫這個設定準備；已經在準備的設定不變。
+    // 試了 maxRequestAttempts 個候選盤面還找不到就放棄 (callback 的 found 是 false)
+    void request(const Config &config);
+    // 不要 request 的盤面了 (玩家已經開始玩或換了大小)；start 的設定繼續準備
+    void cancel(const Config &config);
+    // 有設定準備好盤面 (found 是 true) 或 request 的設定放棄了 (false) 時在背景執行緒呼叫
+    // (要在 start / request 之前設定)
+    void setFoundCallback(std::function<void(const Config &, bool found)> callback) { onFound = std::move(callback); }
+    void stop();  // 停下所有執行緒 (已經找到的盤面保留)
+
+    // 拿走準備好的盤面，拿走之後背景會再準備下一個；還沒找到就等到 timeoutMs 為止
+    bool take(const Config &config, Result *result, int timeoutMs = 0);
+
+    // 從 startIndex 開始只用推論能不能解開整個盤面 (會打開 board 上的格子)，
+    // cancel 變成 true 就馬上放棄 (回傳 false)
+    static bool verify(MinesweeperBoard &board, int startIndex, Solver &solver, const std::atomic<bool> *cancel = nullptr);
+
+    static constexpr int maxRequestAttempts = 4096;  // request 的設定最多試幾個候選盤面
+
+private:
+    struct Slot {
+        Config config;
+        bool ready = false;
+        Result result;
+        bool once = false;  // request 加的，拿走就刪掉
+        int attempts = 0;   // 試過幾個候選盤面 (只有 once 的會放棄)
+    };
+
+    void addSlots(const std::vector<Config> &configs, bool once);
+    void work(int worker);
+    int slotOf(const Config &config) const;  // 呼叫前要先鎖 mutex
+
+    int m_threadCount;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;   // 有盤面被拿走或加了新的設定
+    std::condition_variable found;  // 找到新的盤面
+    std::vector<Slot> slots;
+    std::atomic<bool> stopping{ false };  // 改的時候要鎖 mutex，工作中的執行緒不鎖直接看
+    std::atomic<uint64_t> nextSeed{ 0 };
+    std::function<void(const Config &, bool)> onFound;
+};
+
+#endif // NOGUESSGENERATOR_H
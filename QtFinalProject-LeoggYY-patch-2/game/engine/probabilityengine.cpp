@@ -0,0 +1,366 @@
+﻿#include "probabilityengine.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+using Cell = MinesweeperBoard::CellBits;
+
+namespace {
+
+constexpr int maxComponentCells = 200;  // 超過就不精確計算 (當成一般格子)
+constexpr size_t maxStates = 1 << 14;   // 動態規劃每一層最多幾個狀態
+
+// 多項式相乘 (下標是地雷數)，只保留到 limit，再縮放成最大值是 1 避免溢位
+// 縮放的倍數在算機率時會被分子分母消掉
+std::vector<double> convolve(const std::vector<double> &a, const std::vector<double> &b, size_t limit) {
+    std::vector<double> out(std::min(limit, a.size() + b.size() - 1), 0.0);
+    for (size_t i = 0; i < a.size() && i < out.size(); ++i) {
+        if (a[i] == 0) continue;
+        for (size_t j = 0; j < b.size() && i + j < out.size(); ++j) {
+            out[i + j] += a[i] * b[j];
+        }
+    }
+    double peak = *std::max_element(out.begin(), out.end());
+    if (peak > 0) {
+        for (double &value : out) value /= peak;
+    }
+    return out;
+}
+
+// target += source * x^shift
+void addShifted(std::vector<double> &target, const std::vector<double> &source, int shift) {
+    if (target.size() < source.size() + shift) target.resize(source.size() + shift, 0.0);
+    for (size_t i = 0; i < source.size(); ++i) target[i + shift] += source[i];
+}
+
+double logChoose(int n, int k) {
+    return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+}
+
+void appendInt(std::string &key, int value) {
+    key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+} // namespace
+
+void ProbabilityEngine::compute(const MinesweeperBoard &board, const Solver &solver) {
+    buildComponents(board, solver);
+
+    // 內容跟上一次一樣的區域直接沿用，只有這一步碰到的區域要重新算
+    std::unordered_map<std::string, std::shared_ptr<Result>> nextCache;
+    std::vector<size_t> pending;
+    results.assign(components.size(), nullptr);
+    m_reusedComponents = 0;
+    for (size_t i = 0; i < components.size(); ++i) {
+        auto cached = cache.find(components[i].key);
+        if (cached != cache.end()) {
+            results[i] = cached->second;
+            ++m_reusedComponents;
+        } else {
+            results[i] = std::make_shared<Result>();
+            pending.push_back(i);
+        }
+        nextCache.emplace(components[i].key, results[i]);
+    }
+    cache.swap(nextCache);  // 這一次沒出現的區域從快取移除
+    m_componentCount = int(components.size());
+
+    // 每個執行緒輪流拿下一個要算的區域
+    std::atomic<size_t> next{ 0 };
+    auto work = [&]() {
+        for (size_t i = next++; i < pending.size(); i = next++) {
+            solveComponent(components[pending[i]], results[pending[i]].get());
+        }
+    };
+    size_t threads = m_threadCount > 0 ? size_t(m_threadCount) : size_t(std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, pending.size()));
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t) pool.emplace_back(work);
+    work();
+    for (std::thread &thread : pool) thread.join();
+
+    m_exact = true;
+    for (size_t i = 0; i < components.size(); ++i) {
+        if (results[i]->solved) continue;
+        m_exact = false;
+        interior.insert(interior.end(), components[i].vars.begin(), components[i].vars.end());
+    }
+    combine(board.mineCount() - solver.knownMineCount(), int(interior.size()));
+}
+
+void ProbabilityEngine::buildComponents(const MinesweeperBoard &board, const Solver &solver) {
+    const int *neighbours = board.neighbourOffsets();
+    m_probability.assign(board.paddedSize(), -1.0f);
+    componentOf.assign(board.paddedSize(), -1);
+    positionOf.assign(board.paddedSize(), -1);
+    visited.assign(board.paddedSize(), -1);
+    components.clear();
+    interior.clear();
+
+    auto isUnknown = [&](int idx) {
+        return !(board.cell(idx) & Cell::RevealedBit) && !solver.isKnownSafe(idx) && !solver.isKnownMine(idx);
+    };
+    auto isConstraint = [&](int idx) {
+        uint8_t cell = board.cell(idx);
+        return (cell & (Cell::RevealedBit | Cell::BorderBit | Cell::MineBit)) == Cell::RevealedBit
+               && (cell & Cell::CountMask);
+    };
+
+    for (int i = 0; i < board.rows(); ++i) {
+        int idx = board.index(i, 0);
+        for (int j = 0; j < board.cols(); ++j, ++idx) {
+            if (board.cell(idx) & Cell::RevealedBit) continue;
+            if (solver.isKnownSafe(idx)) {
+                m_probability[idx] = 0.0f;
+                continue;
+            }
+            if (solver.isKnownMine(idx)) {
+                m_probability[idx] = 1.0f;
+                continue;
+            }
+            if (componentOf[idx] >= 0) continue;
+
+            bool frontier = false;
+            for (int k = 0; k < 8 && !frontier; ++k) frontier = isConstraint(idx + neighbours[k]);
+            if (!frontier) {
+                interior.push_back(idx);
+                continue;
+            }
+
+            // 從這個格子開始找出整個區域 (格子和數字輪流擴展)
+            int id = int(components.size());
+            Component component;
+            componentOf[idx] = id;
+            component.vars.push_back(idx);
+            for (size_t head = 0; head < component.vars.size(); ++head) {
+                int var = component.vars[head];
+                for (int k = 0; k < 8; ++k) {
+                    int number = var + neighbours[k];
+                    if (!isConstraint(number) || visited[number] == id) continue;
+                    visited[number] = id;
+
+                    int needed = board.cell(number) & Cell::CountMask;
+                    std::vector<int> cells;
+                    for (int n = 0; n < 8; ++n) {
+                        int other = number + neighbours[n];
+                        if (solver.isKnownMine(other)) {
+                            --needed;
+                        } else if (isUnknown(other)) {
+                            if (componentOf[other] != id) {
+                                componentOf[other] = id;
+                                component.vars.push_back(other);
+                            }
+                            cells.push_back(other);
+                        }
+                    }
+                    component.needed.push_back(needed);
+                    component.constraintVars.push_back(std::move(cells));
+                }
+            }
+
+            for (size_t v = 0; v < component.vars.size(); ++v) {
+                positionOf[component.vars[v]] = int(v);
+                appendInt(component.key, component.vars[v]);
+            }
+            appendInt(component.key, -1);
+            for (size_t c = 0; c < component.needed.size(); ++c) {
+                appendInt(component.key, component.needed[c]);
+                for (int &cell : component.constraintVars[c]) {
+                    cell = positionOf[cell];
+                    appendInt(component.key, cell);
+                }
+                appendInt(component.key, -1);
+            }
+            components.push_back(std::move(component));
+        }
+    }
+}
+
+// 依照 vars 的順序逐格決定，狀態是「已經碰到但還沒結束的數字各自還缺幾個地雷」，
+// 狀態相同的部分盤面接下來的可能性完全一樣，可以合併 (等於把回溯的結果記起來)。
+// 往前算出走到每個狀態的方法數，往回算出從每個狀態走到底的方法數，兩者相乘就是每一格是地雷的盤面數。
+void ProbabilityEngine::solveComponent(const Component &component, Result *result) {
+    const int n = int(component.vars.size());
+    const int m = int(component.needed.size());
+    result->solved = false;
+    if (n > maxComponentCells) return;
+
+    std::vector<int> first(m, n), last(m, -1);
+    std::vector<std::vector<int>> startsAt(n);
+    for (int c = 0; c < m; ++c) {
+        for (int pos : component.constraintVars[c]) {
+            first[c] = std::min(first[c], pos);
+            last[c] = std::max(last[c], pos);
+        }
+        if (first[c] < n) startsAt[first[c]].push_back(c);
+    }
+
+    struct Layer {
+        std::vector<int> open;  // 狀態裡每個位置是哪個數字
+        std::unordered_map<std::string, int> lookup;
+        std::vector<std::string> keys;
+        std::vector<std::vector<double>> forward;
+        std::vector<int> next[2];  // 決定這一格 (0 安全、1 地雷) 之後到下一層的哪個狀態
+    };
+    std::vector<Layer> layers(n + 1);
+    layers[0].keys.push_back(std::string());
+    layers[0].lookup.emplace(std::string(), 0);
+    layers[0].forward.push_back({ 1.0 });
+
+    for (int i = 0; i < n; ++i) {
+        Layer &current = layers[i];
+        Layer &following = layers[i + 1];
+
+        // 這一格會碰到的數字：上一層還開著的 + 從這一格開始的
+        struct Involved { int constraint; int from; bool uses; int left; };
+        std::vector<Involved> involved;
+        auto describe = [&](int c, int from) {
+            const std::vector<int> &cells = component.constraintVars[c];
+            Involved entry{ c, from, false, 0 };
+            for (int pos : cells) {
+                if (pos == i) entry.uses = true;
+                if (pos > i) ++entry.left;
+            }
+            involved.push_back(entry);
+            if (last[c] != i) following.open.push_back(c);
+        };
+        for (size_t p = 0; p < current.open.size(); ++p) describe(current.open[p], int(p));
+        for (int c : startsAt[i]) describe(c, -1);
+
+        current.next[0].assign(current.keys.size(), -1);
+        current.next[1].assign(current.keys.size(), -1);
+        std::string key;
+        for (size_t s = 0; s < current.keys.size(); ++s) {
+            for (int value = 0; value <= 1; ++value) {
+                key.clear();
+                bool feasible = true;
+                for (const Involved &entry : involved) {
+                    int remaining = entry.from >= 0 ? current.keys[s][entry.from]
+                                                    : component.needed[entry.constraint];
+                    if (entry.uses) remaining -= value;
+                    if (remaining < 0 || remaining > entry.left) {  // 結束的數字 left 是 0，所以一定要剛好滿足
+                        feasible = false;
+                        break;
+                    }
+                    if (entry.left > 0) key.push_back(char(remaining));
+                }
+                if (!feasible) continue;
+
+                auto inserted = following.lookup.emplace(key, int(following.keys.size()));
+                if (inserted.second) {
+                    following.keys.push_back(key);
+                    following.forward.emplace_back();
+                }
+                int target = inserted.first->second;
+                current.next[value][s] = target;
+                addShifted(following.forward[target], current.forward[s], value);
+            }
+        }
+        if (following.keys.size() > maxStates || following.keys.empty()) return;
+    }
+
+    // 往回：從每個狀態走到底、各放幾個地雷的方法數
+    std::vector<std::vector<std::vector<double>>> backward(n + 1);
+    backward[n].assign(1, { 1.0 });
+    for (int i = n - 1; i >= 0; --i) {
+        const Layer &layer = layers[i];
+        backward[i].assign(layer.keys.size(), {});
+        for (size_t s = 0; s < layer.keys.size(); ++s) {
+            for (int value = 0; value <= 1; ++value) {
+                int target = layer.next[value][s];
+                if (target >= 0) addShifted(backward[i][s], backward[i + 1][target], value);
+            }
+        }
+    }
+
+    result->total = layers[n].forward[0];
+    result->mines.assign(n, std::vector<double>(n + 1, 0.0));
+    for (int i = 0; i < n; ++i) {
+        const Layer &layer = layers[i];
+        std::vector<double> &mines = result->mines[i];
+        for (size_t s = 0; s < layer.keys.size(); ++s) {
+            int target = layer.next[1][s];
+            if (target < 0) continue;
+            const std::vector<double> &before = layer.forward[s];
+            const std::vector<double> &after = backward[i + 1][target];
+            for (size_t a = 0; a < before.size(); ++a) {
+                for (size_t b = 0; b < after.size(); ++b) mines[a + b + 1] += before[a] * after[b];
+            }
+        }
+    }
+
+    double peak = *std::max_element(result->total.begin(), result->total.end());
+    for (double &value : result->total) value /= peak;
+    for (std::vector<double> &mines : result->mines) {
+        for (double &value : mines) value /= peak;
+    }
+    result->solved = true;
+}
+
+void ProbabilityEngine::combine(int remainingMines, int interiorCells) {
+    const size_t limit = size_t(std::max(remainingMines, 0)) + 1;
+    std::vector<size_t> solved;
+    for (size_t i = 0; i < components.size(); ++i) {
+        if (results[i]->solved) solved.push_back(i);
+    }
+
+    // prefix[j]：前 j 個區域合起來放 k 個地雷的盤面數，suffix 同理，用來算「除了某個區域以外」
+    std::vector<std::vector<double>> prefix(solved.size() + 1), suffix(solved.size() + 1);
+    prefix[0] = { 1.0 };
+    suffix[solved.size()] = { 1.0 };
+    for (size_t j = 0; j < solved.size(); ++j) {
+        prefix[j + 1] = convolve(prefix[j], results[solved[j]]->total, limit);
+    }
+    for (size_t j = solved.size(); j-- > 0;) {
+        suffix[j] = convolve(results[solved[j]]->total, suffix[j + 1], limit);
+    }
+    const std::vector<double> &all = prefix[solved.size()];
+
+    // weight[x]：區域裡一共放 x 個地雷時，其他格子的放法 C(interiorCells, remainingMines - x) (縮放過)
+    std::vector<double> weight(limit, 0.0);
+    double maxLog = -INFINITY;
+    for (size_t x = 0; x < limit && x < all.size(); ++x) {
+        int rest = remainingMines - int(x);
+        if (all[x] > 0 && rest <= interiorCells) maxLog = std::max(maxLog, logChoose(interiorCells, rest));
+    }
+    if (maxLog == -INFINITY) {
+        m_exact = false;  // 跟畫面矛盾 (不應該發生)
+        return;
+    }
+    for (size_t x = 0; x < limit; ++x) {
+        int rest = remainingMines - int(x);
+        if (rest >= 0 && rest <= interiorCells) weight[x] = std::exp(logChoose(interiorCells, rest) - maxLog);
+    }
+
+    // 一般的格子：平均分到剩下的地雷
+    double total = 0;
+    double interiorMines = 0;
+    for (size_t x = 0; x < all.size(); ++x) {
+        total += all[x] * weight[x];
+        interiorMines += all[x] * weight[x] * (remainingMines - int(x));
+    }
+    float interiorProbability = interiorCells > 0 ? float(interiorMines / total / interiorCells) : 0.0f;
+    for (int idx : interior) m_probability[idx] = interiorProbability;
+
+    // 區域裡的格子：其他區域和一般格子的所有放法當權重
+    std::vector<double> others(limit);
+    for (size_t j = 0; j < solved.size(); ++j) {
+        const Component &component = components[solved[j]];
+        const Result &result = *results[solved[j]];
+        std::vector<double> rest = convolve(prefix[j], suffix[j + 1], limit);
+        std::fill(others.begin(), others.end(), 0.0);
+        for (size_t k = 0; k < limit; ++k) {
+            for (size_t t = 0; t < rest.size() && k + t < limit; ++t) others[k] += rest[t] * weight[k + t];
+        }
+
+        double componentTotal = 0;
+        for (size_t k = 0; k < result.total.size() && k < limit; ++k) componentTotal += result.total[k] * others[k];
+        for (size_t v = 0; v < component.vars.size(); ++v) {
+            double mines = 0;
+            const std::vector<double> &byCount = result.mines[v];
+            for (size_t k = 0; k < byCount.size() && k < limit; ++k) mines += byCount[k] * others[k];
+            m_probability[component.vars[v]] = componentTotal > 0 ? float(mines / componentTotal) : 0.0f;
+        }
+    }
+}
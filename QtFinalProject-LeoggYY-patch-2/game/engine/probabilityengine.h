@@ -0,0 +1,67 @@
+﻿#ifndef PROBABILITYENGINE_H
+#define PROBABILITYENGINE_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "minesweeperboard.h"
+#include "solver.h"
+
+// 算出每個沒打開的格子是地雷的機率 (在所有符合畫面的盤面裡，地雷總數固定)
+//
+// 1. 靠著數字的格子依照共用的數字分成互不相關的區域
+// 2. 每個區域依序決定每個格子，把「還在考慮中的數字各自還缺幾個地雷」當成狀態合併 (動態規劃)，
+//    算出區域裡放 k 個地雷的盤面數，以及每個格子是地雷的盤面數
+// 3. 其他不靠著數字的格子用組合數 C(格子數, 剩下的地雷數) 當權重，把所有區域合起來
+//
+// 區域之間互不影響，所以用多個執行緒一起算；結果依照區域的內容快取，
+// 下一步沒有碰到的區域內容不會變，直接沿用上一次的結果。
+class ProbabilityEngine
+{
+public:
+    // solver 推論出來的格子直接是 0 或 1，可以讓區域變小 (solver 要先 reset/update 過)
+    void compute(const MinesweeperBoard &board, const Solver &solver);
+
+    // 格子是地雷的機率 (0~1)；已經打開的格子是 -1
+    float probability(int index) const { return m_probability[index]; }
+    // false 代表有區域太大沒辦法精確計算，那一塊當成一般的格子估計
+    bool isExact() const { return m_exact; }
+    int componentCount() const { return m_componentCount; }
+    int reusedComponents() const { return m_reusedComponents; }  // 這次沿用快取的區域數
+
+    void setThreadCount(int threads) { m_threadCount = threads; }  // 0 代表用全部的核心
+
+private:
+    struct Component {
+        std::vector<int> vars;                        // 格子 (index)，依照 BFS 的順序
+        std::vector<int> needed;                      // 每個數字還缺幾個地雷
+        std::vector<std::vector<int>> constraintVars; // 每個數字周圍的格子在 vars 裡的位置
+        std::string key;                              // 快取用：格子和數字的內容
+    };
+    struct Result {
+        bool solved = false;
+        std::vector<double> total;                 // total[k]：區域裡放 k 個地雷的盤面數 (縮放過)
+        std::vector<std::vector<double>> mines;    // mines[v][k]：其中 vars[v] 是地雷的盤面數
+    };
+
+    void buildComponents(const MinesweeperBoard &board, const Solver &solver);
+    static void solveComponent(const Component &component, Result *result);
+    void combine(int remainingMines, int interiorCells);
+
+    std::vector<float> m_probability;
+    std::vector<Component> components;
+    std::vector<std::shared_ptr<Result>> results;
+    std::unordered_map<std::string, std::shared_ptr<Result>> cache;
+    std::vector<int> componentOf;  // 格子 -> 區域編號 (-1 代表不在任何區域)
+    std::vector<int> positionOf;   // 格子 -> 在區域的 vars 裡的位置
+    std::vector<int> visited;      // 數字格子 -> 最後一次被哪個區域用到
+    std::vector<int> interior;     // 不靠著數字 (或區域太大) 的格子
+
+    bool m_exact = true;
+    int m_componentCount = 0;
+    int m_reusedComponents = 0;
+    int m_threadCount = 0;
+};
+
+#endif // PROBABILITYENGINE_H
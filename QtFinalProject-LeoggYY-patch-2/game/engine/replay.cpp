@@ -0,0 +1,239 @@
+﻿#include "replay.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+using GameState = MinesweeperBoard::GameState;
+
+namespace {
+
+const char magic[4] = { 'M', 'S', 'R', 'P' };
+constexpr uint8_t version = 1;
+constexpr uint64_t endRecord = 7;         // 結束記錄的 action
+constexpr int64_t maxCells = int64_t(1) << 28;  // 讀檔時拒絕不合理的大小
+
+void putVarint(std::vector<uint8_t> &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(uint8_t(value));
+}
+
+class Reader
+{
+public:
+    Reader(const uint8_t *data, size_t size) : data(data), end(data + size) {}
+
+    bool atEnd() const { return data == end; }
+
+    bool byte(uint8_t *value) {
+        if (data == end) return false;
+        *value = *data++;
+        return true;
+    }
+
+    bool varint(uint64_t *value) {
+        *value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b;
+            if (!byte(&b)) return false;
+            *value |= uint64_t(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;  // 超過 10 個 byte
+    }
+
+    bool fixed64(uint64_t *value) {
+        *value = 0;
+        for (int k = 0; k < 8; ++k) {
+            uint8_t b;
+            if (!byte(&b)) return false;
+            *value |= uint64_t(b) << (8 * k);
+        }
+        return true;
+    }
+
+private:
+    const uint8_t *data;
+    const uint8_t *end;
+};
+
+} // namespace
+
+void Replay::start(const MinesweeperBoard &board, int startCell) {
+    rows = board.rows();
+    cols = board.cols();
+    mineCount = board.mineCount();
+    seed = board.seed();
+    winRule = board.winRule();
+    this->startCell = startCell;
+    moves.clear();
+    hasOutcome = false;
+    outcome = GameState::Playing;
+}
+
+void Replay::setOutcome(GameState state) {
+    hasOutcome = state != GameState::Playing;
+    outcome = state;
+}
+
+std::vector<uint8_t> Replay::encode() const {
+    std::vector<uint8_t> out(magic, magic + 4);
+    out.reserve(32 + moves.size() * 3);
+    out.push_back(version);
+    putVarint(out, uint64_t(rows));
+    putVarint(out, uint64_t(cols));
+    putVarint(out, uint64_t(mineCount));
+    for (int k = 0; k < 8; ++k) out.push_back(uint8_t(seed >> (8 * k)));
+    out.push_back(uint8_t(winRule));
+    putVarint(out, uint64_t(startCell + 1));
+
+    for (const Move &move : moves) {
+        putVarint(out, (uint64_t(move.cell) << 3) | uint64_t(move.action));
+        putVarint(out, move.delayMicros);
+    }
+    if (hasOutcome) {
+        putVarint(out, (uint64_t(outcome) << 3) | endRecord);
+        putVarint(out, 0);
+    }
+    return out;
+}
+
+bool Replay::decode(const uint8_t *data, size_t size) {
+    Reader reader(data, size);
+    uint8_t header[5];
+    for (uint8_t &b : header) {
+        if (!reader.byte(&b)) return false;
+    }
+    if (!std::equal(magic, magic + 4, header) || header[4] != version) return false;
+
+    uint64_t r, c, mines, start;
+    uint8_t rule;
+    if (!reader.varint(&r) || !reader.varint(&c) || !reader.varint(&mines) || !reader.fixed64(&seed)
+        || !reader.byte(&rule) || !reader.varint(&start))
+        return false;
+    if (r == 0 || c == 0 || r > uint64_t(maxCells) || c > uint64_t(maxCells) || int64_t(r * c) > maxCells) return false;
+    const int64_t cells = int64_t(r * c);
+    if (mines > uint64_t(cells) || rule > uint8_t(WinRule::Either) || start > uint64_t(cells)) return false;
+    rows = int(r);
+    cols = int(c);
+    mineCount = int(mines);
+    winRule = WinRule(rule);
+    startCell = int(start) - 1;
+
+    moves.clear();
+    hasOutcome = false;
+    outcome = GameState::Playing;
+    while (!reader.atEnd()) {
+        uint64_t record, delay;
+        if (hasOutcome || !reader.varint(&record) || !reader.varint(&delay)) return false;  // 結束記錄之後不能再有東西
+        const uint64_t action = record & 7;
+        const uint64_t cell = record >> 3;
+        if (action == endRecord) {
+            if (cell != uint64_t(GameState::Won) && cell != uint64_t(GameState::Lost)) return false;
+            hasOutcome = true;
+            outcome = GameState(cell);
+            continue;
+        }
+        if (action > uint64_t(Action::RevealAll) || cell >= uint64_t(cells)) return false;
+        moves.push_back({ Action(action), int(cell), delay });
+    }
+    return true;
+}
+
+bool Replay::save(const std::string &path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+    const std::vector<uint8_t> bytes = encode();
+    file.write(reinterpret_cast<const char *>(bytes.data()), std::streamsize(bytes.size()));
+    return bool(file);
+}
+
+bool Replay::load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return decode(bytes.data(), bytes.size());
+}
+
+ReplayPlayer::ReplayPlayer()
+    : journal(SIZE_MAX)  // 記錄時能悔的每一步重播時都要能悔
+{
+}
+
+void ReplayPlayer::start(const Replay &replay, MinesweeperBoard &board) {
+    this->replay = &replay;
+    this->board = &board;
+    next = 0;
+    m_ignoredMoves = 0;
+    changed.clear();
+    journal.clear();
+
+    board.resize(replay.rows, replay.cols, replay.mineCount);
+    board.setWinRule(replay.winRule);
+    if (replay.startCell >= 0) {
+        board.initializeGame(replay.seed, replay.startCell / replay.cols, replay.startCell % replay.cols);
+    } else {
+        board.prepareGame(replay.seed);
+    }
+}
+
+bool ReplayPlayer::step() {
+    changed.clear();
+    if (atEnd()) return false;
+    const Replay::Move &move = replay->moves[next++];
+    const int index = board->index(move.cell / replay->cols, move.cell % replay->cols);
+    const GameState before = board->state();
+
+    bool applied = true;
+    switch (move.action) {
+    case Replay::Action::Reveal:
+    case Replay::Action::Chord: {
+        auto result = move.action == Replay::Action::Reveal ? board->revealAt(index) : board->chordAt(index);
+        applied = result != MinesweeperBoard::RevealResult::Ignored;
+        if (applied) {
+            journal.record(*board, before);
+            changed = board->changedCells();
+            if (board->state() != GameState::Playing) finishGame();
+        }
+        break;
+    }
+    case Replay::Action::Flag: {
+        auto result = board->toggleFlagAt(index);
+        applied = result != MinesweeperBoard::FlagResult::Ignored;
+        if (applied) {
+            journal.record(*board, before);
+            changed = board->changedCells();
+            // Widget 拔掉旗子剛好贏的時候直接開新的一局，不打開地雷
+            if (board->state() == GameState::Won && result == MinesweeperBoard::FlagResult::Placed) finishGame();
+        }
+        break;
+    }
+    case Replay::Action::Undo:
+    case Replay::Action::Redo:
+        applied = move.action == Replay::Action::Undo ? journal.undo(*board) : journal.redo(*board);
+        if (applied) changed = board->changedCells();
+        break;
+    case Replay::Action::RevealAll:  // T 鍵：自己算一步
+        applied = before == GameState::Playing;
+        if (applied) {
+            board->revealAllBombs();
+            journal.record(*board, before);
+            changed = board->changedCells();
+        }
+        break;
+    }
+    if (!applied) ++m_ignoredMoves;
+    return applied;
+}
+
+void ReplayPlayer::finishGame() {
+    board->revealAllBombs();
+    journal.append(*board);
+    changed.insert(changed.end(), board->changedCells().begin(), board->changedCells().end());
+}
+
+void ReplayPlayer::runToEnd() {
+    while (!atEnd()) step();
+}
@@ -0,0 +1,84 @@
+﻿#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "minesweeperboard.h"
+#include "movejournal.h"
+
+// 重播檔 (二進位)。盤面不存，用種子重新產生：
+//   "MSRP"、版本 (1 byte)
+//   varint rows、cols、mineCount，seed (8 bytes little endian)，WinRule (1 byte)
+//   varint startCell + 1 (0 代表第一下才放地雷 (prepareGame)，否則 initializeGame(seed, 那一格))
+//   之後每一步兩個 varint：(cell << 3) | action、跟上一步相差幾微秒
+//   最後可以有一個結束記錄 (action 7)，cell 是最後的 GameState
+// cell 是 row * cols + col (跟 MinesweeperBoard::index 不同，不含邊框)。
+class Replay
+{
+public:
+    using GameState = MinesweeperBoard::GameState;
+    using WinRule = MinesweeperBoard::WinRule;
+
+    enum class Action : uint8_t { Reveal, Flag, Chord, Undo, Redo, RevealAll };
+
+    struct Move {
+        Action action;
+        int cell;
+        uint64_t delayMicros;  // 跟上一步 (第一步是開局) 相差幾微秒
+    };
+
+    int rows = 0;
+    int cols = 0;
+    int mineCount = 0;
+    uint64_t seed = 0;
+    WinRule winRule = WinRule::Either;
+    int startCell = -1;  // 不用猜的盤面從這格開始 (已經放好地雷)，-1 代表第一下才放
+    std::vector<Move> moves;
+    bool hasOutcome = false;  // 存檔時遊戲已經結束
+    GameState outcome = GameState::Playing;
+
+    // 開始記錄一局：大小、種子和 WinRule 從 board 拿 (board 要剛 prepareGame 或 initializeGame 完)
+    void start(const MinesweeperBoard &board, int startCell = -1);
+    void add(Action action, int cell, uint64_t delayMicros) { moves.push_back({ action, cell, delayMicros }); }
+    void setOutcome(GameState state);
+
+    std::vector<uint8_t> encode() const;
+    bool decode(const uint8_t *data, size_t size);  // 格式不對回傳 false
+    bool save(const std::string &path) const;
+    bool load(const std::string &path);
+};
+
+// 照著重播檔玩：用同一個種子產生盤面，流程跟 Widget 一樣
+// (踩到地雷或贏了就打開所有地雷並併進同一步，悔棋用 MoveJournal)。
+// 即時或 N 倍速播放由呼叫端依照 nextDelayMicros() 等待，不等待就是最快速度。
+class ReplayPlayer
+{
+public:
+    ReplayPlayer();
+
+    void start(const Replay &replay, MinesweeperBoard &board);  // 改變 board 的大小並產生盤面
+    bool atEnd() const { return !replay || next >= replay->moves.size(); }
+    size_t position() const { return next; }  // 做了幾步
+    uint64_t nextDelayMicros() const { return atEnd() ? 0 : replay->moves[next].delayMicros; }
+
+    // 做下一步；changedCells() 是這一步改變的格子 (MinesweeperBoard::index)
+    // 記錄的動作沒有效果 (跟記錄時的盤面對不上) 回傳 false
+    bool step();
+    void runToEnd();  // 不等待，做完全部的步驟
+    const std::vector<int> &changedCells() const { return changed; }
+    int ignoredMoves() const { return m_ignoredMoves; }  // 沒有效果的步驟數
+
+private:
+    void finishGame();  // 遊戲結束：跟 Widget 一樣打開所有地雷
+
+    const Replay *replay = nullptr;
+    MinesweeperBoard *board = nullptr;
+    MoveJournal journal;
+    size_t next = 0;
+    std::vector<int> changed;
+    int m_ignoredMoves = 0;
+};
+
+#endif // REPLAY_H
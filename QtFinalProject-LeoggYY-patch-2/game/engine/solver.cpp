@@ -0,0 +1,316 @@
+﻿#include "solver.h"
+#include <algorithm>
+
+using Cell = MinesweeperBoard::CellBits;
+
+namespace {
+constexpr int64_t nodeBudget = 1 << 16;  // 一次窮舉最多走幾個節點，超過就放棄這一塊
+}
+
+void Solver::reset(const MinesweeperBoard *board) {
+    this->board = board;
+    neighbours = board->neighbourOffsets();
+    knowledge.assign(board->paddedSize(), Unknown);
+    marks.assign(board->paddedSize(), 0);
+    varIndex.assign(board->paddedSize(), -1);
+    dirty.clear();
+    stale.clear();
+    safe.clear();
+    mines.clear();
+    m_unknownCount = board->rows() * board->cols();
+    m_knownMines = 0;
+
+    // 新的一局通常沒有打開的格子，只有中途接手時才需要
+    for (int i = 0; i < board->rows(); ++i) {
+        int idx = board->index(i, 0);
+        for (int j = 0; j < board->cols(); ++j, ++idx) {
+            if (board->cell(idx) & Cell::RevealedBit) open(idx);
+        }
+    }
+}
+
+void Solver::update(const std::vector<int> &changedCells) {
+    if (!board) return;
+    for (int idx : changedCells) {
+        if (board->cell(idx) & Cell::RevealedBit) open(idx);  // 旗子不影響推論
+    }
+}
+
+void Solver::solve() {
+    if (!board) return;
+    for (;;) {
+        propagate();
+        safe.erase(std::remove_if(safe.begin(), safe.end(), [this](int idx) { return knowledge[idx] != Safe; }),
+                   safe.end());
+        // 已經有安全的格子就先停下來：打開之後通常就推得出更多，比窮舉便宜很多
+        // (還沒窮舉的數字格子留在 stale 裡，下次 solve 再做)
+        if (!safe.empty()) break;
+        if (!applyGlobalCount() && !enumerateStale()) break;
+    }
+}
+
+bool Solver::isConstraint(int index) const {
+    uint8_t cell = board->cell(index);
+    return (cell & (Cell::RevealedBit | Cell::BorderBit | Cell::MineBit)) == Cell::RevealedBit
+           && (cell & Cell::CountMask);
+}
+
+void Solver::evaluate(int index, Constraint *constraint) const {
+    constraint->size = 0;
+    constraint->mines = board->cell(index) & Cell::CountMask;
+    for (int k = 0; k < 8; ++k) {
+        int next = index + neighbours[k];
+        if (knowledge[next] == Mine) {
+            --constraint->mines;
+        } else if (knowledge[next] == Unknown && !(board->cell(next) & Cell::RevealedBit)) {
+            constraint->cells[constraint->size++] = next;
+        }
+    }
+}
+
+void Solver::open(int index) {
+    if (knowledge[index] == Opened) return;
+    if (knowledge[index] == Unknown) --m_unknownCount;
+    knowledge[index] = Opened;
+    if (board->cell(index) & Cell::MineBit) return;  // 踩到地雷，遊戲已經結束
+
+    if (isConstraint(index)) markDirty(index);
+    for (int k = 0; k < 8; ++k) {
+        int next = index + neighbours[k];
+        if (isConstraint(next)) markDirty(next);
+    }
+}
+
+void Solver::learn(int index, Knowledge value) {
+    if (knowledge[index] != Unknown) return;
+    knowledge[index] = value;
+    --m_unknownCount;
+    ++m_learned;
+    if (value == Mine) {
+        ++m_knownMines;
+        mines.push_back(index);
+    } else {
+        safe.push_back(index);
+    }
+    for (int k = 0; k < 8; ++k) {
+        int next = index + neighbours[k];
+        if (isConstraint(next)) markDirty(next);
+    }
+}
+
+void Solver::markDirty(int index) {
+    if (!(marks[index] & Dirty)) {
+        marks[index] |= Dirty;
+        dirty.push_back(index);
+    }
+    if (!(marks[index] & Stale)) {
+        marks[index] |= Stale;
+        stale.push_back(index);
+    }
+}
+
+// 規則 1、2：只處理有改變的數字格子
+void Solver::propagate() {
+    while (!dirty.empty()) {
+        int index = dirty.back();
+        dirty.pop_back();
+        marks[index] &= ~Dirty;
+
+        Constraint a;
+        evaluate(index, &a);
+        if (a.size == 0) continue;
+        if (a.mines == 0 || a.mines == a.size) {
+            Knowledge value = a.mines == 0 ? Safe : Mine;
+            for (int i = 0; i < a.size; ++i) learn(a.cells[i], value);
+            continue;
+        }
+        applySubsets(index, a);
+    }
+}
+
+void Solver::applySubsets(int index, const Constraint &a) {
+    int seen[24];  // 5x5 範圍內的其他數字格子
+    int seenCount = 0;
+    for (int i = 0; i < a.size; ++i) {
+        for (int k = 0; k < 8; ++k) {
+            int other = a.cells[i] + neighbours[k];
+            if (other == index || !isConstraint(other)) continue;
+            if (std::find(seen, seen + seenCount, other) != seen + seenCount) continue;
+            seen[seenCount++] = other;
+
+            Constraint b;
+            evaluate(other, &b);
+            if (b.size == 0) continue;
+            // 學到新的格子之後 index 會重新排進 dirty，這裡先停下來
+            if (applyDifference(b, a) || applyDifference(a, b)) return;
+        }
+    }
+}
+
+bool Solver::applyDifference(const Constraint &big, const Constraint &small) {
+    if (small.size >= big.size) return false;
+    int diff[8];
+    int diffCount = 0;
+    for (int i = 0; i < big.size; ++i) {
+        if (std::find(small.cells, small.cells + small.size, big.cells[i]) == small.cells + small.size) {
+            diff[diffCount++] = big.cells[i];
+        }
+    }
+    if (diffCount != big.size - small.size) return false;  // small 不是 big 的子集合
+
+    int diffMines = big.mines - small.mines;
+    if (diffMines != 0 && diffMines != diffCount) return false;
+    Knowledge value = diffMines == 0 ? Safe : Mine;
+    for (int i = 0; i < diffCount; ++i) learn(diff[i], value);
+    return true;
+}
+
+// 地雷總數：地雷都找到了就全部安全，剩下的格子數剛好等於地雷數就全部是地雷
+bool Solver::applyGlobalCount() {
+    if (m_unknownCount == 0) return false;
+    Knowledge value;
+    if (m_knownMines == board->mineCount()) value = Safe;
+    else if (m_knownMines + m_unknownCount == board->mineCount()) value = Mine;
+    else return false;
+
+    for (int i = 0; i < board->rows(); ++i) {
+        int idx = board->index(i, 0);
+        for (int j = 0; j < board->cols(); ++j, ++idx) {
+            if (!(board->cell(idx) & Cell::RevealedBit)) learn(idx, value);
+        }
+    }
+    return true;
+}
+
+// 規則 3：上次窮舉之後有改變的數字格子，連同附近的數字一起窮舉
+bool Solver::enumerateStale() {
+    if (stale.empty()) return false;
+    staleWork.swap(stale);
+    stale.clear();
+    for (int index : staleWork) marks[index] &= ~Stale;
+
+    int learned = m_learned;
+    for (int index : staleWork) {
+        if ((marks[index] & Covered) || !isConstraint(index)) continue;
+        enumerateAround(index);
+    }
+    for (int index : coveredCells) marks[index] &= ~Covered;
+    coveredCells.clear();
+    return m_learned != learned;
+}
+
+bool Solver::enumerateAround(int index) {
+    // 從 index 開始往外找相連的數字格子，直到變數超過上限
+    // 只取一部分的數字格子一樣正確：少了條件只會多出可能的解，不會推出錯的結果
+    vars.clear();
+    problem.clear();
+    candidates.clear();
+    candidates.push_back(index);
+    marks[index] |= InProblem;
+    bool complete = true;
+
+    for (size_t head = 0; head < candidates.size(); ++head) {
+        Constraint constraint;
+        evaluate(candidates[head], &constraint);
+        if (constraint.size == 0) continue;
+
+        int newVars = 0;
+        for (int i = 0; i < constraint.size; ++i) {
+            if (varIndex[constraint.cells[i]] < 0) ++newVars;
+        }
+        if (int(vars.size()) + newVars > m_enumerationLimit) {
+            complete = false;
+            continue;
+        }
+
+        problem.push_back(constraint);
+        for (int i = 0; i < constraint.size; ++i) {
+            int cell = constraint.cells[i];
+            if (varIndex[cell] >= 0) continue;
+            varIndex[cell] = int(vars.size());
+            vars.push_back(cell);
+            for (int k = 0; k < 8; ++k) {
+                int other = cell + neighbours[k];
+                if ((marks[other] & InProblem) || !isConstraint(other)) continue;
+                marks[other] |= InProblem;
+                candidates.push_back(other);
+            }
+        }
+    }
+    for (int cell : candidates) marks[cell] &= ~InProblem;
+
+    if (complete) {
+        // 整個相連的區域都窮舉過了，同一塊的其他數字這一輪不用再做
+        for (int cell : candidates) {
+            if (!(marks[cell] & Covered)) {
+                marks[cell] |= Covered;
+                coveredCells.push_back(cell);
+            }
+        }
+    }
+
+    bool solved = false;
+    if (problem.size() >= 2) {  // 只有一個數字的話規則 1 已經處理過了
+        size_t varCount = vars.size();
+        varConstraints.resize(varCount * 8);
+        varConstraintCount.assign(varCount, 0);
+        needed.resize(problem.size());
+        unassigned.resize(problem.size());
+        for (size_t c = 0; c < problem.size(); ++c) {
+            needed[c] = problem[c].mines;
+            unassigned[c] = problem[c].size;
+            for (int i = 0; i < problem[c].size; ++i) {
+                int var = varIndex[problem[c].cells[i]];
+                varConstraints[size_t(var) * 8 + varConstraintCount[var]++] = int(c);
+            }
+        }
+        assignment.assign(varCount, 0);
+        mineSolutions.assign(varCount, 0);
+        solutionCount = 0;
+        nodesLeft = nodeBudget;
+        solved = search(0) && solutionCount > 0;
+    }
+
+    // 先把變數編號清掉，learn 之後 index 周圍的格子可能又被拿來窮舉
+    for (int cell : vars) varIndex[cell] = -1;
+    if (!solved) return false;
+
+    int learned = m_learned;
+    for (size_t v = 0; v < vars.size(); ++v) {
+        if (mineSolutions[v] == 0) learn(vars[v], Safe);
+        else if (mineSolutions[v] == solutionCount) learn(vars[v], Mine);
+    }
+    return m_learned != learned;
+}
+
+// 依序決定每個變數是不是地雷，任何數字格子不可能滿足就剪掉；超過節點上限回傳 false
+bool Solver::search(int var) {
+    if (--nodesLeft < 0) return false;
+    if (var == int(vars.size())) {
+        ++solutionCount;
+        for (size_t v = 0; v < assignment.size(); ++v) mineSolutions[v] += assignment[v];
+        return true;
+    }
+
+    const int *constraints = &varConstraints[size_t(var) * 8];
+    int count = varConstraintCount[var];
+    for (int value = 0; value <= 1; ++value) {
+        bool feasible = true;
+        for (int j = 0; j < count; ++j) {
+            int c = constraints[j];
+            --unassigned[c];
+            needed[c] -= value;
+            if (needed[c] < 0 || needed[c] > unassigned[c]) feasible = false;
+        }
+        assignment[var] = uint8_t(value);
+        bool finished = !feasible || search(var + 1);
+        for (int j = 0; j < count; ++j) {
+            int c = constraints[j];
+            ++unassigned[c];
+            needed[c] += value;
+        }
+        if (!finished) return false;
+    }
+    assignment[var] = 0;
+    return true;
+}
@@ -0,0 +1,97 @@
+﻿#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <cstdint>
+#include <vector>
+#include "minesweeperboard.h"
+
+// 只看畫面上看得到的資訊 (打開的數字)，推論哪些格子一定安全、哪些一定是地雷
+//
+// 推論的順序：
+//   1. 單一數字：剩下的地雷數是 0 或等於沒確定的格子數
+//   2. 兩個數字的子集合：A 的格子都在 B 裡面，B 多出來的格子有 B - A 個地雷
+//   3. 窮舉：把相連的數字格子一起列出所有可能的地雷分布 (太大就只取附近一塊)
+//
+// 盤面每次改變後呼叫 update(changedCells)，只有受影響的數字會重新檢查，
+// 所以在很大的盤面上 solve() 的時間只跟上一步改變的範圍有關，不會重新掃描整個盤面。
+// 旗子是玩家自己插的，可能插錯，所以不當作地雷，只相信推論出來的結果。
+class Solver
+{
+public:
+    void reset(const MinesweeperBoard *board);  // 新的一局 (initializeGame 之後)
+    void update(const std::vector<int> &changedCells);  // 盤面改變後 (reveal / toggleFlag)
+    void solve();  // 推論到找出安全的格子，或是再也推不出新結果為止
+
+    // 推論出來、還沒打開的安全格子 (index)
+    const std::vector<int> &safeCells() const { return safe; }
+    // 推論出來的地雷 (可能已經插了旗子)
+    const std::vector<int> &mineCells() const { return mines; }
+    bool isKnownSafe(int index) const { return knowledge[index] == Safe; }
+    bool isKnownMine(int index) const { return knowledge[index] == Mine; }
+    int unknownCount() const { return m_unknownCount; }  // 沒打開也還沒推論出來的格子數
+    int knownMineCount() const { return m_knownMines; }  // 推論出來的地雷數
+
+    // 窮舉時一次最多考慮幾個格子 (越大推得越多，但最差情況越慢)
+    void setEnumerationLimit(int cells) { m_enumerationLimit = cells; }
+
+private:
+    enum Knowledge : uint8_t { Unknown, Safe, Mine, Opened };
+    enum Marks : uint8_t {
+        Dirty = 1,    // 在 dirty 佇列裡 (要重新套用規則 1、2)
+        Stale = 2,    // 在 stale 佇列裡 (上次窮舉之後有改變)
+        Covered = 4,  // 這一輪已經被完整窮舉過
+        InProblem = 8 // 已經排進這次窮舉的候選
+    };
+
+    // 一個數字格子周圍還沒確定的格子，以及其中還有幾個地雷
+    struct Constraint {
+        int cells[8];
+        int size = 0;
+        int mines = 0;
+    };
+
+    bool isConstraint(int index) const;
+    void evaluate(int index, Constraint *constraint) const;
+    void open(int index);
+    void learn(int index, Knowledge value);
+    void markDirty(int index);
+
+    void propagate();
+    void applySubsets(int index, const Constraint &a);
+    bool applyDifference(const Constraint &big, const Constraint &small);
+    bool applyGlobalCount();
+    bool enumerateStale();
+    bool enumerateAround(int index);
+    bool search(int var);
+
+    const MinesweeperBoard *board = nullptr;
+    const int *neighbours = nullptr;
+    std::vector<uint8_t> knowledge;
+    std::vector<uint8_t> marks;
+    std::vector<int> dirty;
+    std::vector<int> stale;
+    std::vector<int> staleWork;
+    std::vector<int> safe;
+    std::vector<int> mines;
+    int m_unknownCount = 0;
+    int m_knownMines = 0;
+    int m_learned = 0;
+    int m_enumerationLimit = 20;
+
+    // 窮舉用的暫存
+    std::vector<int> varIndex;       // 格子 -> 變數編號 (-1 代表不在這次窮舉裡)
+    std::vector<int> vars;           // 變數 -> 格子
+    std::vector<int> varConstraints; // 每個變數最多 8 個數字格子
+    std::vector<int> varConstraintCount;
+    std::vector<int> candidates;      // 這次窮舉考慮過的數字格子
+    std::vector<Constraint> problem;  // 這次窮舉採用的數字格子
+    std::vector<int> coveredCells;    // 這一輪標成 Covered 的格子
+    std::vector<int> needed;          // 每個數字格子還需要幾個地雷
+    std::vector<int> unassigned;      // 每個數字格子還沒決定的變數數
+    std::vector<uint8_t> assignment;
+    std::vector<int64_t> mineSolutions; // 每個變數是地雷的解的數量
+    int64_t solutionCount = 0;
+    int64_t nodesLeft = 0;
+};
+
+#endif // SOLVER_H
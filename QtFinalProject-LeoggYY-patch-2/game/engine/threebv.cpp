@@ -0,0 +1,45 @@
+﻿#include "threebv.h"
+
+int ThreeBV::compute(const MinesweeperBoard &board) {
+    using Cell = MinesweeperBoard::CellBits;
+    const int *neighbours = board.neighbourOffsets();
+    marked.assign(board.paddedSize(), 0);
+
+    auto isSafe = [&board](int idx) {
+        return !(board.cell(idx) & (Cell::MineBit | Cell::BorderBit));
+    };
+
+    int clicks = 0;
+
+    // 每一塊空白區域 (連同它周圍的數字) 點一下就全部打開
+    for (int i = 0; i < board.rows(); ++i) {
+        int idx = board.index(i, 0);
+        for (int j = 0; j < board.cols(); ++j, ++idx) {
+            if (marked[idx] || !isSafe(idx) || (board.cell(idx) & Cell::CountMask)) continue;
+
+            ++clicks;
+            marked[idx] = 1;
+            stack.clear();
+            stack.push_back(idx);
+            while (!stack.empty()) {
+                int current = stack.back();
+                stack.pop_back();
+                for (int k = 0; k < 8; ++k) {
+                    int next = current + neighbours[k];
+                    if (marked[next] || !isSafe(next)) continue;
+                    marked[next] = 1;
+                    if ((board.cell(next) & Cell::CountMask) == 0) stack.push_back(next);
+                }
+            }
+        }
+    }
+
+    // 剩下的數字格子每個都要點一下
+    for (int i = 0; i < board.rows(); ++i) {
+        int idx = board.index(i, 0);
+        for (int j = 0; j < board.cols(); ++j, ++idx) {
+            if (!marked[idx] && isSafe(idx)) ++clicks;
+        }
+    }
+    return clicks;
+}
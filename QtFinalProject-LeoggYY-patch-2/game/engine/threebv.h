@@ -0,0 +1,21 @@
+﻿#ifndef THREEBV_H
+#define THREEBV_H
+
+#include <cstdint>
+#include <vector>
+#include "minesweeperboard.h"
+
+// 3BV (Bechtel's Board Benchmark Value)：不插旗子的情況下，最少要點幾下才能打開整個盤面。
+// 每一塊相連的空白區域算一下，再加上不靠著任何空白格子的數字格子。
+// 暫存陣列留在物件裡，同一個物件重複計算不會再配置記憶體。
+class ThreeBV
+{
+public:
+    int compute(const MinesweeperBoard &board);
+
+private:
+    std::vector<uint8_t> marked;  // 已經被某一下點擊打開的格子
+    std::vector<int> stack;
+};
+
+#endif // THREEBV_H
@@ -0,0 +1,17 @@
+QT += gui
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+# 效能測試框架沿用 bench，格子外觀沿用 untitled1
+INCLUDEPATH += ../bench ../untitled1
+
+SOURCES += \
+    ../bench/benchmark.cpp \
+    ../untitled1/cellfacecache.cpp \
+    main.cpp
+
+HEADERS += \
+    ../bench/benchmark.h \
+    ../untitled1/cellfacecache.h
+
+include(../engine/engine.pri)
@@ -0,0 +1,103 @@
+﻿#include <QGuiApplication>
+#include <QImage>
+#include <QPainter>
+#include <vector>
+#include "benchmark.h"
+#include "cellfacecache.h"
+#include "minesweeperboard.h"
+
+// 畫格子的效能比較：每個格子 fillRect + drawText (以前的作法) 和 CellFaceCache 的 drawPixmap
+// 參數是 cols/rows/cellSize，每次迭代畫一整個畫面 (離屏的 QImage，不受螢幕更新影響)
+//
+//   facebench --benchmark_filter=Face -platform offscreen
+//
+// 沒有螢幕的機器要加 -platform offscreen (或設定 QT_QPA_PLATFORM=offscreen)。
+
+namespace {
+
+// 一個玩到一半的盤面：大約 3/5 打開、一些旗子，數字和地雷都有
+std::vector<uint8_t> makeCells(int rows, int cols) {
+    MinesweeperBoard board(rows, cols, rows * cols / 6);
+    board.initializeGame(1);
+    std::vector<uint8_t> cells;
+    cells.reserve(size_t(rows) * cols);
+    uint32_t state = 12345;
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            uint8_t cell = board.cell(board.index(i, j));
+            state = state * 1664525u + 1013904223u;
+            uint32_t roll = (state >> 16) % 10;
+            if (roll < 6) cell |= MinesweeperBoard::RevealedBit;
+            else if (roll == 6) cell |= MinesweeperBoard::FlagBit;
+            cells.push_back(cell);
+        }
+    }
+    return cells;
+}
+
+QImage makeTarget(const bench::State &state) {
+    QImage image(int(state.range(0) * state.range(2)), int(state.range(1) * state.range(2)),
+                 QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    return image;
+}
+
+// 以前的作法：每個格子都重新排版文字 (emoji 還要找備用字型)
+void BM_FaceDrawText(bench::State &state) {
+    const int cols = int(state.range(0)), rows = int(state.range(1)), size = int(state.range(2));
+    const std::vector<uint8_t> cells = makeCells(rows, cols);
+    QImage image = makeTarget(state);
+    for (auto _ : state) {
+        QPainter painter(&image);
+        for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                CellFaceCache::paintFace(painter, QRect(j * size, i * size, size, size),
+                                         CellFaceCache::faceOf(cells[size_t(i) * cols + j]));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * rows * cols);
+}
+BENCHMARK(BM_FaceDrawText)->Apply([](bench::Benchmark *b) {
+    b->Args({ 10, 10, 30 })->Args({ 20, 20, 30 })->Args({ 64, 36, 30 })->Args({ 240, 135, 8 });
+});
+
+// 快取：每個格子只是一次 drawPixmap
+void BM_FacePixmap(bench::State &state) {
+    const int cols = int(state.range(0)), rows = int(state.range(1)), size = int(state.range(2));
+    const std::vector<uint8_t> cells = makeCells(rows, cols);
+    QImage image = makeTarget(state);
+    CellFaceCache faces;
+    faces.setCellSize(size);
+    for (auto _ : state) {
+        QPainter painter(&image);
+        for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                faces.draw(painter, QPoint(j * size, i * size), CellFaceCache::faceOf(cells[size_t(i) * cols + j]));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * rows * cols);
+}
+BENCHMARK(BM_FacePixmap)->Apply([](bench::Benchmark *b) {
+    b->Args({ 10, 10, 30 })->Args({ 20, 20, 30 })->Args({ 64, 36, 30 })->Args({ 240, 135, 8 });
+});
+
+// 建立一個格子大小的快取 (縮放到還沒畫過的大小時要付的代價)
+void BM_FaceCacheBuild(bench::State &state) {
+    const int size = int(state.range(0));
+    CellFaceCache faces;
+    for (auto _ : state) {
+        faces.clear();
+        faces.setCellSize(size);
+    }
+    state.SetItemsProcessed(state.iterations() * CellFaceCache::FaceCount);
+}
+BENCHMARK(BM_FaceCacheBuild)->Args({ 8 })->Args({ 30 })->Args({ 60 });
+
+} // namespace
+
+int main(int argc, char **argv) {
+    QGuiApplication app(argc, argv);  // 字型需要 QGuiApplication，Qt 自己的參數 (-platform) 會先被拿掉
+    return bench::runAll(argc, argv);
+}
@@ -0,0 +1,15 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    engine \
+    untitled1 \
+    bench \
+    facebench \
+    simulator \
+    tests
+
+untitled1.depends = engine
+bench.depends = engine
+facebench.depends = engine
+simulator.depends = engine
+tests.depends = engine
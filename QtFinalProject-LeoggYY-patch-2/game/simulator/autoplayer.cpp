@@ -0,0 +1,104 @@
+﻿#include "autoplayer.h"
+
+using Cell = MinesweeperBoard::CellBits;
+using GameState = MinesweeperBoard::GameState;
+
+AutoPlayer::Result AutoPlayer::play(MinesweeperBoard &board, GameRandom &rng) {
+    rules = nullptr;
+    return run(board, rng);
+}
+
+AutoPlayer::Result AutoPlayer::play(BitBoard &rules, MinesweeperBoard &view, GameRandom &rng) {
+    this->rules = &rules;
+    Result result = run(view, rng);
+    this->rules = nullptr;
+    return result;
+}
+
+AutoPlayer::Result AutoPlayer::run(MinesweeperBoard &board, GameRandom &rng) {
+    Result result;
+    solver.reset(&board);
+    reveal(board, board.index(board.rows() / 2, board.cols() / 2), &result);
+
+    while (board.state() == GameState::Playing) {
+        solver.solve();
+
+        if (!solver.safeCells().empty()) {
+            moves = solver.safeCells();
+            for (int idx : moves) {
+                if (board.state() != GameState::Playing) break;
+                reveal(board, idx, &result);
+            }
+            continue;
+        }
+
+        // 沒有安全的格子了：如果其他格子都打開了還沒贏 (WinRule::FlagMines)，把推論出來的地雷插上旗子
+        if (solver.unknownCount() == 0) {
+            for (int idx : solver.mineCells()) {
+                if (board.cell(idx) & Cell::FlagBit) continue;
+                flag(board, idx, &result);
+            }
+            break;
+        }
+
+        if (!guess(board, rng, &result)) break;
+    }
+
+    result.won = board.state() == GameState::Won;
+    return result;
+}
+
+void AutoPlayer::reveal(MinesweeperBoard &board, int index, Result *result) {
+    ++result->clicks;
+    if (rules) {
+        rules->reveal(board.rowOf(index), board.colOf(index));
+        mirror(board);
+    } else {
+        board.revealAt(index);
+    }
+    solver.update(board.changedCells());
+}
+
+void AutoPlayer::flag(MinesweeperBoard &board, int index, Result *result) {
+    ++result->clicks;
+    if (rules) {
+        rules->toggleFlag(board.rowOf(index), board.colOf(index));
+        mirror(board);
+    } else {
+        board.toggleFlagAt(index);
+    }
+}
+
+void AutoPlayer::mirror(MinesweeperBoard &view) {
+    // changedWords 是每個 word 裡改變的位元，換成 view 的 index；
+    // restoreCells 只改打開/旗子的位元，順便把輸贏也抄過去
+    mirrored.clear();
+    mirroredBits.clear();
+    for (const BitBoard::WordChange &change : rules->changedWords()) {
+        const int row = rules->rowOfWord(change.word);
+        int col = rules->colOfWord(change.word);
+        for (uint64_t bits = change.bits; bits; bits >>= 1, ++col) {
+            if (!(bits & 1)) continue;
+            mirrored.push_back(view.index(row, col));
+            mirroredBits.push_back(uint8_t((rules->isRevealed(row, col) ? Cell::RevealedBit : 0)
+                                           | (rules->isFlagged(row, col) ? Cell::FlagBit : 0)));
+        }
+    }
+    view.restoreCells(mirrored.data(), mirroredBits.data(), int(mirrored.size()), rules->state());
+}
+
+// 隨機打開一個還不確定的格子
+bool AutoPlayer::guess(MinesweeperBoard &board, GameRandom &rng, Result *result) {
+    covered.clear();
+    for (int i = 0; i < board.rows(); ++i) {
+        int idx = board.index(i, 0);
+        for (int j = 0; j < board.cols(); ++j, ++idx) {
+            if (!(board.cell(idx) & Cell::RevealedBit) && !solver.isKnownMine(idx)) covered.push_back(idx);
+        }
+    }
+    if (covered.empty()) return false;
+
+    ++result->guesses;
+    reveal(board, covered[rng.bounded(uint64_t(covered.size()))], result);
+    return true;
+}
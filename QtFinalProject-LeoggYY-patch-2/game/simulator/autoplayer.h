@@ -0,0 +1,45 @@
+﻿#ifndef AUTOPLAYER_H
+#define AUTOPLAYER_H
+
+#include <cstdint>
+#include <vector>
+#include "bitboard.h"
+#include "gamerandom.h"
+#include "minesweeperboard.h"
+#include "solver.h"
+
+// 自動玩一局：先點正中間，之後打開 Solver 推論出來的安全格子，推不出來就隨機猜一個還不確定的格子。
+// 打開所有安全的格子就贏了 (WinRule::RevealSafe / Either)；盤面用 WinRule::FlagMines 時
+// 最後再把推論出來的地雷全部插上旗子
+class AutoPlayer
+{
+public:
+    struct Result {
+        bool won = false;
+        int clicks = 0;   // 打開 + 插旗子的次數
+        int guesses = 0;  // 其中用猜的次數
+    };
+
+    // board 要先 prepareGame (跟 Widget 一樣第一下才放地雷，第一下一定安全) 或 initializeGame；
+    // rng 只用來猜格子
+    Result play(MinesweeperBoard &board, GameRandom &rng);
+    // 用 BitBoard 判定規則 (打開、插旗子、輸贏)；view 是同一個盤面的 MinesweeperBoard
+    // (兩個都用同一個種子 initializeGame)，每一步把 BitBoard 改變的格子抄過去給 Solver 讀
+    Result play(BitBoard &rules, MinesweeperBoard &view, GameRandom &rng);
+
+private:
+    Result run(MinesweeperBoard &board, GameRandom &rng);
+    void reveal(MinesweeperBoard &board, int index, Result *result);
+    void flag(MinesweeperBoard &board, int index, Result *result);
+    void mirror(MinesweeperBoard &view);  // 把 rules 上一個動作改變的格子抄到 view
+    bool guess(MinesweeperBoard &board, GameRandom &rng, Result *result);
+
+    BitBoard *rules = nullptr;  // 沒有的話直接在 MinesweeperBoard 上玩
+    Solver solver;
+    std::vector<int> moves;    // 這一輪要做的動作 (Solver 的結果會在動作之後改變，先複製出來)
+    std::vector<int> covered;  // 猜的時候用的暫存
+    std::vector<int> mirrored;  // mirror 用的暫存
+    std::vector<uint8_t> mirroredBits;
+};
+
+#endif // AUTOPLAYER_H
@@ -0,0 +1,355 @@
+﻿#include "autoplayer.h"
+#include "replay.h"
+#include "threebv.h"
+#include "workstealingpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// 沒有畫面的批次模擬：用 Widget 的難度設定 (或自訂大小) 自動玩很多局，統計勝率、點擊數和 3BV
+//
+//   simulator --games=1000000 --preset=all --custom=30x16x99 --out=summary.csv --histogram=3bv.csv
+//
+// 每一局的種子由 --seed 和局數決定，所以結果跟用了幾個執行緒無關。
+// --backend=bitboard 改用 BitBoard 判定規則：同一個種子是同一個盤面，勝率、猜的次數和 3BV 跟預設的 bytes 一樣；
+// 改變的格子順序不同 (BitBoard 是依照 word)，Solver 給的安全格子順序跟著不同，平均點擊數會有一點差別。
+//
+//   simulator --validate=replays/ --validate=game.msr
+//
+// 批次檢查重播檔 (資料夾裡所有的 .msr)：用種子重新產生盤面、照 Widget 的流程最快速度重玩，
+// 每一步都要有效果，最後的結果要跟存檔時一樣。
+
+namespace {
+
+struct Config {
+    std::string name;
+    int rows;
+    int cols;
+    int mines;
+};
+
+enum class Backend {
+    Bytes,    // MinesweeperBoard (每格一個 byte)
+    BitBoard  // BitBoard 判定規則，MinesweeperBoard 只給 Solver 讀
+};
+
+// 每個執行緒自己的盤面、暫存和統計，對齊 cache line 避免 false sharing
+struct alignas(64) Worker {
+    MinesweeperBoard board;
+    BitBoard bits;
+    AutoPlayer player;
+    ThreeBV threeBV;
+    GameRandom rng;
+
+    int64_t games = 0;
+    int64_t wins = 0;
+    int64_t clicks = 0;
+    int64_t guesses = 0;
+    std::vector<int64_t> gamesBy3bv;  // 3BV -> 局數
+    std::vector<int64_t> winsBy3bv;
+};
+
+struct Summary {
+    Config config;
+    int64_t games = 0;
+    int64_t wins = 0;
+    int64_t clicks = 0;
+    int64_t guesses = 0;
+    std::vector<int64_t> gamesBy3bv;
+    std::vector<int64_t> winsBy3bv;
+    double seconds = 0;
+
+    int64_t threeBVPercentile(double p) const {
+        int64_t rank = std::max<int64_t>(1, int64_t(p * games + 0.5));
+        int64_t seen = 0;
+        for (size_t i = 0; i < gamesBy3bv.size(); ++i) {
+            seen += gamesBy3bv[i];
+            if (seen >= rank) return int64_t(i);
+        }
+        return 0;
+    }
+    double average3bv() const {
+        double sum = 0;
+        for (size_t i = 0; i < gamesBy3bv.size(); ++i) sum += double(i) * gamesBy3bv[i];
+        return games ? sum / games : 0;
+    }
+};
+
+constexpr int gamesPerTask = 256;  // 一次工作玩幾局 (太小會一直搶佇列的鎖)
+
+uint64_t gameSeed(uint64_t baseSeed, int64_t game) {
+    uint64_t state = baseSeed + uint64_t(game) * 0x9E3779B97F4A7C15ull;
+    return GameRandom::splitMix64(state);
+}
+
+Summary simulate(WorkStealingPool &pool, const Config &config, int64_t games, uint64_t baseSeed, Backend backend) {
+    std::vector<Worker> workers(size_t(pool.threadCount()));
+    for (Worker &worker : workers) {
+        worker.board.resize(config.rows, config.cols, config.mines);
+        if (backend == Backend::BitBoard) worker.bits.resize(config.rows, config.cols, config.mines);
+        worker.gamesBy3bv.assign(size_t(config.rows) * config.cols + 1, 0);
+        worker.winsBy3bv.assign(worker.gamesBy3bv.size(), 0);
+    }
+
+    int taskCount = int((games + gamesPerTask - 1) / gamesPerTask);
+    auto start = std::chrono::steady_clock::now();
+    pool.run(taskCount, [&](int id, int task) {
+        Worker &worker = workers[size_t(id)];
+        int64_t begin = int64_t(task) * gamesPerTask;
+        int64_t end = std::min(games, begin + gamesPerTask);
+        for (int64_t game = begin; game < end; ++game) {
+            uint64_t seed = gameSeed(baseSeed, game);
+            worker.board.clear();
+            worker.rng.setSeed(~seed);
+            AutoPlayer::Result result;
+            if (backend == Backend::BitBoard) {
+                // BitBoard 沒有 prepareGame：直接避開第一下 (正中間) 放地雷，跟 prepareGame 之後點正中間是同一個盤面
+                worker.bits.clear();
+                worker.bits.initializeGame(seed, config.rows / 2, config.cols / 2);
+                worker.board.initializeGame(seed, config.rows / 2, config.cols / 2);
+                result = worker.player.play(worker.bits, worker.board, worker.rng);
+            } else {
+                worker.board.prepareGame(seed);  // 跟 Widget 一樣第一下 (正中間) 才放地雷
+                result = worker.player.play(worker.board, worker.rng);
+            }
+            int threeBV = worker.threeBV.compute(worker.board);  // 只看地雷和數字，打開過的格子不影響
+            ++worker.games;
+            worker.clicks += result.clicks;
+            worker.guesses += result.guesses;
+            ++worker.gamesBy3bv[size_t(threeBV)];
+            if (result.won) {
+                ++worker.wins;
+                ++worker.winsBy3bv[size_t(threeBV)];
+            }
+        }
+    });
+
+    Summary summary;
+    summary.config = config;
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    summary.gamesBy3bv.assign(workers[0].gamesBy3bv.size(), 0);
+    summary.winsBy3bv.assign(workers[0].winsBy3bv.size(), 0);
+    for (const Worker &worker : workers) {
+        summary.games += worker.games;
+        summary.wins += worker.wins;
+        summary.clicks += worker.clicks;
+        summary.guesses += worker.guesses;
+        for (size_t i = 0; i < summary.gamesBy3bv.size(); ++i) {
+            summary.gamesBy3bv[i] += worker.gamesBy3bv[i];
+            summary.winsBy3bv[i] += worker.winsBy3bv[i];
+        }
+    }
+    return summary;
+}
+
+void writeSummary(std::ostream &out, const std::vector<Summary> &summaries) {
+    out << "config,rows,cols,mines,games,wins,win_rate,avg_clicks,avg_guesses,avg_3bv,p10_3bv,p50_3bv,p90_3bv,games_per_sec\n";
+    for (const Summary &s : summaries) {
+        out << s.config.name << ',' << s.config.rows << ',' << s.config.cols << ',' << s.config.mines << ','
+            << s.games << ',' << s.wins << ',' << double(s.wins) / s.games << ','
+            << double(s.clicks) / s.games << ',' << double(s.guesses) / s.games << ','
+            << s.average3bv() << ',' << s.threeBVPercentile(0.1) << ',' << s.threeBVPercentile(0.5) << ','
+            << s.threeBVPercentile(0.9) << ',' << s.games / s.seconds << '\n';
+    }
+}
+
+// 3BV 分布 (只列出有出現的值)
+void writeHistogram(std::ostream &out, const std::vector<Summary> &summaries) {
+    out << "config,3bv,games,wins,win_rate\n";
+    for (const Summary &s : summaries) {
+        for (size_t i = 0; i < s.gamesBy3bv.size(); ++i) {
+            if (s.gamesBy3bv[i] == 0) continue;
+            out << s.config.name << ',' << i << ',' << s.gamesBy3bv[i] << ',' << s.winsBy3bv[i] << ','
+                << double(s.winsBy3bv[i]) / s.gamesBy3bv[i] << '\n';
+        }
+    }
+}
+
+// 重播檔檢查：每個執行緒自己的盤面
+struct alignas(64) Checker {
+    Replay replay;
+    MinesweeperBoard board;
+    ReplayPlayer player;
+    int64_t moves = 0;
+};
+
+const char *stateName(MinesweeperBoard::GameState state) {
+    switch (state) {
+    case MinesweeperBoard::GameState::Won: return "won";
+    case MinesweeperBoard::GameState::Lost: return "lost";
+    default: return "playing";
+    }
+}
+
+std::vector<std::string> replayFiles(const std::vector<std::string> &paths) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    for (const std::string &path : paths) {
+        std::error_code error;
+        if (!fs::is_directory(path, error)) {
+            files.push_back(path);
+            continue;
+        }
+        for (const auto &entry : fs::recursive_directory_iterator(path, error)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".msr") files.push_back(entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// 回傳有問題的檔案數
+int64_t validateReplays(WorkStealingPool &pool, const std::vector<std::string> &paths) {
+    const std::vector<std::string> files = replayFiles(paths);
+    std::vector<Checker> checkers(size_t(pool.threadCount()));
+    std::vector<std::string> problems(files.size());  // 空字串代表沒問題
+    std::vector<uint8_t> checked(files.size(), 0);     // 有存結果的才算真的比對過
+
+    auto start = std::chrono::steady_clock::now();
+    pool.run(int(files.size()), [&](int id, int task) {
+        Checker &checker = checkers[size_t(id)];
+        if (!checker.replay.load(files[size_t(task)])) {
+            problems[size_t(task)] = "cannot read or corrupt";
+            return;
+        }
+        checker.player.start(checker.replay, checker.board);
+        checker.player.runToEnd();
+        checker.moves += int64_t(checker.replay.moves.size());
+
+        char message[128] = "";
+        if (checker.player.ignoredMoves() > 0) {
+            std::snprintf(message, sizeof(message), "%d of %zu moves had no effect", checker.player.ignoredMoves(),
+                          checker.replay.moves.size());
+        } else if (checker.replay.hasOutcome && checker.replay.outcome != checker.board.state()) {
+            std::snprintf(message, sizeof(message), "recorded %s, replayed %s", stateName(checker.replay.outcome),
+                          stateName(checker.board.state()));
+        }
+        problems[size_t(task)] = message;
+        checked[size_t(task)] = checker.replay.hasOutcome;
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int64_t failed = 0, withOutcome = 0, moves = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        withOutcome += checked[i];
+        if (problems[i].empty()) continue;
+        ++failed;
+        std::fprintf(stderr, "%s: %s\n", files[i].c_str(), problems[i].c_str());
+    }
+    for (const Checker &checker : checkers) moves += checker.moves;
+    std::fprintf(stderr, "%zu replays  %lld failed  %lld with outcome  %.0f replays/s  %.0f moves/s (%d threads)\n",
+                 files.size(), (long long)failed, (long long)withOutcome, files.size() / seconds, moves / seconds,
+                 pool.threadCount());
+    return failed;
+}
+
+bool startsWith(const char *text, const char *prefix, const char **value) {
+    size_t length = std::strlen(prefix);
+    if (std::strncmp(text, prefix, length) != 0) return false;
+    *value = text + length;
+    return true;
+}
+
+// 跟 Widget::setEasy / setNormal / setHard 一樣
+bool addPresets(const std::string &names, std::vector<Config> *configs) {
+    const Config presets[] = { { "easy", 10, 10, 10 }, { "normal", 15, 15, 60 }, { "hard", 20, 20, 80 } };
+    bool found = false;
+    for (const Config &preset : presets) {
+        if (names == "all" || names == preset.name) {
+            configs->push_back(preset);
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool addCustom(const char *text, std::vector<Config> *configs) {
+    Config config;
+    if (std::sscanf(text, "%dx%dx%d", &config.rows, &config.cols, &config.mines) != 3) return false;
+    if (config.rows <= 0 || config.cols <= 0 || config.mines < 0 || config.mines > config.rows * config.cols) return false;
+    config.name = text;
+    configs->push_back(config);
+    return true;
+}
+
+int usage(const char *program) {
+    std::fprintf(stderr, "usage: %s [--games=<n>] [--threads=<n>] [--seed=<n>] [--preset=easy|normal|hard|all]\n"
+                         "          [--custom=<rows>x<cols>x<mines>] [--backend=bytes|bitboard]\n"
+                         "          [--out=<summary.csv>] [--histogram=<3bv.csv>]\n"
+                         "       %s [--threads=<n>] --validate=<file.msr|dir> ...\n",
+                 program, program);
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int64_t games = 100000;
+    int threads = 0;
+    uint64_t seed = 1;
+    std::string outPath = "simulation.csv";
+    std::string histogramPath;
+    std::vector<Config> configs;
+    std::vector<std::string> replays;
+    Backend backend = Backend::Bytes;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *value = nullptr;
+        if (startsWith(argv[i], "--games=", &value)) games = std::atoll(value);
+        else if (startsWith(argv[i], "--threads=", &value)) threads = std::atoi(value);
+        else if (startsWith(argv[i], "--seed=", &value)) seed = std::strtoull(value, nullptr, 10);
+        else if (startsWith(argv[i], "--preset=", &value)) {
+            if (!addPresets(value, &configs)) return usage(argv[0]);
+        } else if (startsWith(argv[i], "--custom=", &value)) {
+            if (!addCustom(value, &configs)) return usage(argv[0]);
+        } else if (startsWith(argv[i], "--out=", &value)) outPath = value;
+        else if (startsWith(argv[i], "--histogram=", &value)) histogramPath = value;
+        else if (startsWith(argv[i], "--validate=", &value)) replays.push_back(value);
+        else if (startsWith(argv[i], "--backend=", &value)) {
+            if (std::strcmp(value, "bytes") == 0) backend = Backend::Bytes;
+            else if (std::strcmp(value, "bitboard") == 0) backend = Backend::BitBoard;
+            else return usage(argv[0]);
+        }
+        else return usage(argv[0]);
+    }
+    if (!replays.empty()) {
+        WorkStealingPool pool(threads);
+        return validateReplays(pool, replays) > 0 ? 2 : 0;
+    }
+    if (games <= 0) return usage(argv[0]);
+    if (configs.empty()) addPresets("all", &configs);
+
+    WorkStealingPool pool(threads);
+    std::vector<Summary> summaries;
+    for (const Config &config : configs) {
+        summaries.push_back(simulate(pool, config, games, seed, backend));
+        const Summary &s = summaries.back();
+        std::fprintf(stderr, "%-12s %lld games  win %.2f%%  %.1f clicks  %.0f games/s (%d threads, %s)\n",
+                     s.config.name.c_str(), (long long)s.games, 100.0 * s.wins / s.games,
+                     double(s.clicks) / s.games, s.games / s.seconds, pool.threadCount(),
+                     backend == Backend::BitBoard ? "bitboard" : "bytes");
+    }
+
+    std::ofstream out(outPath);
+    if (!out) {
+        std::fprintf(stderr, "cannot write %s\n", outPath.c_str());
+        return 1;
+    }
+    writeSummary(out, summaries);
+
+    if (!histogramPath.empty()) {
+        std::ofstream histogram(histogramPath);
+        if (!histogram) {
+            std::fprintf(stderr, "cannot write %s\n", histogramPath.c_str());
+            return 1;
+        }
+        writeHistogram(histogram, summaries);
+    }
+    return 0;
+}
@@ -0,0 +1,15 @@
+TEMPLATE = app
+CONFIG += console c++17 thread
+CONFIG -= app_bundle
+CONFIG -= qt
+
+SOURCES += \
+    autoplayer.cpp \
+    main.cpp \
+    workstealingpool.cpp
+
+HEADERS += \
+    autoplayer.h \
+    workstealingpool.h
+
+include(../engine/engine.pri)
@@ -0,0 +1,60 @@
+﻿#include "workstealingpool.h"
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(int threadCount)
+{
+    if (threadCount <= 0) threadCount = int(std::thread::hardware_concurrency());
+    m_threadCount = std::max(threadCount, 1);
+    for (int i = 0; i < m_threadCount; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+}
+
+void WorkStealingPool::run(int taskCount, const Task &task) {
+    // 先把工作平均切成連續的幾段分給每個執行緒
+    for (int i = 0; i < m_threadCount; ++i) {
+        int begin = int(int64_t(taskCount) * i / m_threadCount);
+        int end = int(int64_t(taskCount) * (i + 1) / m_threadCount);
+        std::lock_guard<std::mutex> lock(queues[i]->mutex);
+        queues[i]->tasks.clear();
+        for (int t = begin; t < end; ++t) queues[i]->tasks.push_back(t);
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < m_threadCount; ++i) {
+        threads.emplace_back(&WorkStealingPool::work, this, i, std::cref(task));
+    }
+    work(0, task);  // 呼叫的執行緒也一起做
+    for (std::thread &thread : threads) thread.join();
+}
+
+void WorkStealingPool::work(int worker, const Task &task) {
+    int next;
+    while (pop(worker, &next) || steal(worker, &next)) {
+        task(worker, next);
+    }
+}
+
+bool WorkStealingPool::pop(int worker, int *task) {
+    Queue &queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    *task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::steal(int worker, int *task) {
+    // 工作只會變少，繞一圈都偷不到就代表全部分完了
+    for (int i = 1; i < m_threadCount; ++i) {
+        Queue &victim = *queues[(worker + i) % m_threadCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        *task = victim.tasks.back();
+        victim.tasks.pop_back();
+        return true;
+    }
+    return false;
+}
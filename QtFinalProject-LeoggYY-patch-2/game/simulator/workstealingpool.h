@@ -0,0 +1,38 @@
+﻿#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 每個執行緒有自己的工作佇列，做完自己的就去別人的佇列尾巴偷工作，
+// 某一批特別慢 (例如大盤面) 也不會讓其他核心閒著
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void(int worker, int task)>;
+
+    explicit WorkStealingPool(int threadCount = 0);  // 0 代表用全部的核心
+
+    int threadCount() const { return m_threadCount; }
+
+    // 執行 task(worker, 0..taskCount-1)，全部做完才回傳；worker 介於 0 ~ threadCount-1
+    void run(int taskCount, const Task &task);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    bool pop(int worker, int *task);    // 從自己的佇列前面拿
+    bool steal(int worker, int *task);  // 從別人的佇列後面偷
+    void work(int worker, const Task &task);
+
+    int m_threadCount;
+    std::vector<std::unique_ptr<Queue>> queues;
+};
+
+#endif // WORKSTEALINGPOOL_H
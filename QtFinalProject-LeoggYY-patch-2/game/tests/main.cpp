@@ -0,0 +1,229 @@
+﻿#include "chunkedboard.h"
+#include "noguessgenerator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+
+// 遊戲邏輯的回歸測試 (沒有畫面)，全部通過回傳 0
+//
+//   tests
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    if (!ok) {
+        std::printf("FAIL %s\n", what);
+        ++failures;
+    }
+}
+
+// 點到的區塊整塊都是地雷時避不開，第一下不能卡住
+void chunkedFirstClickFullTile() {
+    for (uint64_t seed = 0; seed < 8; ++seed) {
+        ChunkedBoard board(128, 128, 128 * 128 - 1, seed);
+        ChunkedBoard::RevealResult result = board.reveal(100, 100);
+        check(board.tileMineCount(1, 1) == 64 * 64, "chunked full tile: tile is full");
+        check(result == ChunkedBoard::RevealResult::Exploded, "chunked full tile: first click explodes");
+    }
+}
+
+// 區塊裡只剩一個安全的格子時放不下 3x3，至少點到的格子一定安全，地雷數不變
+void chunkedFirstClickDenseTile() {
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+        ChunkedBoard board(128, 128, 128 * 128 - 1, seed);
+        check(board.tileMineCount(0, 0) == 64 * 64 - 1, "chunked dense tile: one safe cell");
+        check(board.reveal(10, 10) == ChunkedBoard::RevealResult::Opened, "chunked dense tile: first click is safe");
+        check(board.mineCount() == 128 * 128 - 1, "chunked dense tile: mine count unchanged");
+    }
+    ChunkedBoard endless;
+    endless.resetEndless(7, 0.999);
+    check(endless.reveal(-5000, 123456) == ChunkedBoard::RevealResult::Opened, "chunked endless: first click is safe");
+}
+
+// 已經配置的區塊裡的格子數字要等於周圍的地雷數，旗子踩中地雷的數目要等於 correctCount
+bool chunkedCountsMatch(const ChunkedBoard &board, int row, int col, int span) {
+    int64_t correct = 0;
+    for (int r = row - span; r <= row + span; ++r) {
+        for (int c = col - span; c <= col + span; ++c) {
+            if (!board.isValid(r, c)) continue;
+            const uint8_t bits = board.cell(r, c);
+            if ((bits & ChunkedBoard::CellBits::FlagBit) && (bits & ChunkedBoard::CellBits::MineBit)) ++correct;
+            if (!(bits & ChunkedBoard::CellBits::RevealedBit)) continue;
+            int mines = 0;
+            for (int dr = -1; dr <= 1; ++dr) {
+                for (int dc = -1; dc <= 1; ++dc) {
+                    if ((dr || dc) && board.isValid(r + dr, c + dc) && board.value(r + dr, c + dc) < 0) ++mines;
+                }
+            }
+            if (mines != board.value(r, c)) return false;
+        }
+    }
+    return correct == board.correctCount();
+}
+
+// 跟 MinesweeperBoard 一樣第一下周圍 3x3 都沒有地雷 (第一下一定打開一片)，點到的區塊地雷數不變
+void chunkedFirstClickOpening() {
+    for (uint64_t seed = 0; seed < 16; ++seed) {
+        ChunkedBoard board(300, 300, 300 * 300 * 2 / 5, seed);
+        const int row = 63 + int(seed % 3);  // 3x3 會跨過區塊的邊界
+        const int col = 62 + int(seed * 7 % 4);
+        check(board.reveal(row, col) == ChunkedBoard::RevealResult::Opened, "chunked opening: first click is safe");
+        check(board.value(row, col) == 0, "chunked opening: no mines around first click");
+        int64_t mines = 0;
+        for (int r = 0; r < ChunkedBoard::tileSize; ++r) {
+            for (int c = 0; c < ChunkedBoard::tileSize; ++c) {
+                if (board.value(64 + r, 64 + c) < 0) ++mines;
+            }
+        }
+        check(mines == board.tileMineCount(1, 1), "chunked opening: tile mine count unchanged");
+        check(chunkedCountsMatch(board, row, col, 80), "chunked opening: counts match mines");
+    }
+}
+
+// 先插旗子再點第一下也一樣安全，旗子留著
+void chunkedFirstClickAfterFlag() {
+    for (uint64_t seed = 0; seed < 16; ++seed) {
+        ChunkedBoard board(200, 200, 200 * 200 / 3, seed);
+        board.toggleFlag(64, 64);
+        board.toggleFlag(10, 10);
+        check(board.reveal(63, 63) == ChunkedBoard::RevealResult::Opened, "chunked flag first: first click is safe");
+        check(board.value(63, 63) == 0, "chunked flag first: no mines around first click");
+        check((board.cell(64, 64) & ChunkedBoard::CellBits::FlagBit) && board.flagCount() == 2, "chunked flag first: flags kept");
+        check(chunkedCountsMatch(board, 63, 63, 100), "chunked flag first: counts match mines");
+    }
+}
+
+// 地雷很少的超大盤面第一下只展開活動範圍，其他的等捲過去才展開
+void chunkedSparseFloodBounded() {
+    ChunkedBoard board(100000, 100000, 1000, 5);
+    check(board.reveal(50000, 50000) == ChunkedBoard::RevealResult::Opened, "chunked sparse: first click opens");
+    const size_t first = board.tileCount();
+    check(first < 500, "chunked sparse: tiles bounded");
+    board.keepAround(50000, 50000 + 10 * ChunkedBoard::tileSize);
+    check(!board.changedCells().empty(), "chunked sparse: flood continues when scrolled");
+    check(board.tileCount() < first * 3, "chunked sparse: still bounded after scrolling");
+}
+
+// 無限模式有暫存檔時，一直往右走 (每個區塊都點過) 記憶體不會跟著走過的區塊變多
+void chunkedEndlessMemoryBounded() {
+    const std::string path = (std::filesystem::temp_directory_path() / "tests_chunked.swap").string();
+    ChunkedBoard board;
+    board.resetEndless(3, 0.15);
+    check(board.setSwapFile(path, 0), "chunked endless swap: open swap file");
+    size_t early = 0;
+    size_t peak = 0;
+    for (int step = 0; step < 4000; ++step) {
+        const int col = step * ChunkedBoard::tileSize;
+        board.keepAround(0, col, 2);
+        board.toggleFlag(0, col);  // 讓區塊留在記憶體，才看得到地雷
+        board.toggleFlag(0, col);
+        for (int i = 0; i < ChunkedBoard::tileSize * ChunkedBoard::tileSize; ++i) {
+            const int row = i / ChunkedBoard::tileSize;
+            if (!(board.cell(row, col + i % ChunkedBoard::tileSize) & ChunkedBoard::CellBits::MineBit)) {
+                board.reveal(row, col + i % ChunkedBoard::tileSize);
+                break;
+            }
+        }
+        if (step == 500) early = board.memoryUsage();
+        if (step >= 500) peak = std::max(peak, board.memoryUsage());
+    }
+    check(board.state() == ChunkedBoard::GameState::Playing, "chunked endless swap: still playing");
+    check(board.storedTileCount() > 3000, "chunked endless swap: tiles stored");
+    check(peak < early * 2, "chunked endless swap: memory bounded");
+    board.resetEndless(3, 0.15);
+    std::filesystem::remove(path);
+}
+
+// 來回走 (每次回來都多打開幾格) 時暫存檔要重複使用舊的位置或整理，不能一直變大，
+// 讀回來的盤面要跟沒有暫存檔的一模一樣
+void chunkedEndlessSwapReused() {
+    const std::string path = (std::filesystem::temp_directory_path() / "tests_chunked_walk.swap").string();
+    ChunkedBoard board;
+    ChunkedBoard memory;
+    board.resetEndless(3, 0.15);
+    memory.resetEndless(3, 0.15);
+    check(board.setSwapFile(path, 0), "chunked swap reuse: open swap file");
+    const int span = 300;
+    uintmax_t idleSize = 0;
+    bool idleStable = true;
+    for (int pass = 0; pass < 46; ++pass) {
+        for (int step = 0; step < span; ++step) {
+            const int col = ((pass % 2) ? span - 1 - step : step) * ChunkedBoard::tileSize;
+            for (ChunkedBoard *b : { &board, &memory }) {
+                b->keepAround(0, col, 2);
+                b->toggleFlag(0, col);  // 讓區塊留在記憶體，才看得到地雷
+                b->toggleFlag(0, col);
+            }
+            // 前 40 趟每個區塊多打開 8 格 (區的資料會變大)，之後只走不點
+            for (int i = pass * 97 % 4096, n = 0, opened = 0; pass < 40 && n < 4096 && opened < 8; ++n, i = (i + 1) % 4096) {
+                const int row = i / ChunkedBoard::tileSize;
+                const uint8_t bits = board.cell(row, col + i % ChunkedBoard::tileSize);
+                if (bits & (ChunkedBoard::CellBits::MineBit | ChunkedBoard::CellBits::RevealedBit)) continue;
+                board.reveal(row, col + i % ChunkedBoard::tileSize);
+                memory.reveal(row, col + i % ChunkedBoard::tileSize);
+                ++opened;
+            }
+        }
+        if (pass == 41) idleSize = std::filesystem::file_size(path);
+        if (pass > 41) idleStable &= std::filesystem::file_size(path) == idleSize;
+    }
+    check(idleStable, "chunked swap reuse: walking back and forth keeps the file size");
+    check(std::filesystem::file_size(path) < (1u << 20), "chunked swap reuse: file stays small");
+    check(board.revealedCount() == memory.revealedCount(), "chunked swap reuse: same revealed count");
+    bool same = true;
+    for (int step = 0; step < span; ++step) {
+        const int col = step * ChunkedBoard::tileSize;
+        board.keepAround(0, col, 2);
+        memory.keepAround(0, col, 2);
+        for (int r = -ChunkedBoard::tileSize; r < 2 * ChunkedBoard::tileSize; ++r) {
+            for (int c = col; c < col + ChunkedBoard::tileSize; ++c) same &= board.cell(r, c) == memory.cell(r, c);
+        }
+    }
+    check(same, "chunked swap reuse: cells read back unchanged");
+    board.resetEndless(3, 0.15);
+    std::filesystem::remove(path);
+}
+
+// request 的設定取消之後就拿不到；一直驗證不過的設定試到上限會放棄並通知
+void noGuessRequestEnds() {
+    NoGuessGenerator generator(2);
+    std::atomic<int> gaveUp{ 0 };
+    generator.setFoundCallback([&](const NoGuessGenerator::Config &, bool found) {
+        if (!found) ++gaveUp;
+    });
+    const NoGuessGenerator::Config easy{ 9, 9, 10 };
+    generator.request(easy);
+    generator.cancel(easy);
+    NoGuessGenerator::Result result;
+    check(!generator.take(easy, &result, 1000), "no guess: cancelled request is not taken");
+
+    const NoGuessGenerator::Config dense{ 30, 30, 600 };  // 幾乎不可能不用猜
+    generator.request(dense);
+    for (int i = 0; i < 600 && gaveUp == 0; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    check(gaveUp == 1, "no guess: hopeless request gives up");
+    check(!generator.take(dense, &result), "no guess: given up request is gone");
+    generator.stop();
+}
+
+} // namespace
+
+int main()
+{
+    chunkedFirstClickFullTile();
+    chunkedFirstClickDenseTile();
+    chunkedFirstClickOpening();
+    chunkedFirstClickAfterFlag();
+    chunkedSparseFloodBounded();
+    chunkedEndlessMemoryBounded();
+    chunkedEndlessSwapReused();
+    noGuessRequestEnds();
+    if (failures) return 1;
+    std::printf("all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += console c++17 thread
+CONFIG -= app_bundle
+CONFIG -= qt
+
+SOURCES += \
+    main.cpp
+
+include(../engine/engine.pri)
@@ -0,0 +1,369 @@
+﻿#include "boardview.h"
+#include <QPainter>
+#include <QScreen>
+#include <QScrollBar>
+#include <QStyle>
+#include <QtGlobal>
+#include <algorithm>
+
+BoardView::BoardView(const MinesweeperBoard *board, QWidget *parent)
+    : QAbstractScrollArea(parent), board(board)
+{
+    setupView();
+}
+
+BoardView::BoardView(ChunkedBoard *chunked, QWidget *parent)
+    : QAbstractScrollArea(parent), chunked(chunked)
+{
+    setupView();
+}
+
+void BoardView::setupView() {
+    setFrameShape(QFrame::NoFrame);
+    viewport()->setAttribute(Qt::WA_OpaquePaintEvent);  // 每次都會畫滿整個區域，不用先清背景
+    boardResized();
+}
+
+void BoardView::boardResized() {
+    if (chunked && chunked->endless()) {
+        originRow = originCol = -endlessSpan / 2;
+    } else {
+        originRow = originCol = 0;
+    }
+
+    // 盤面放得下就跟盤面一樣大，放不下就佔螢幕的 80%，其餘用捲動的
+    QSize limit(1600, 1000);
+    if (QScreen *screen = this->screen()) limit = screen->availableSize() * 8 / 10;
+    const int bar = style()->pixelMetric(QStyle::PM_ScrollBarExtent);
+    bool scrollH = contentWidth() > limit.width();
+    bool scrollV = contentHeight() > limit.height();
+    int width = int(qMin<int64_t>(contentWidth(), limit.width()));
+    int height = int(qMin<int64_t>(contentHeight(), limit.height()));
+    setFixedSize(width + (scrollV ? bar : 0), height + (scrollH ? bar : 0));
+
+    updateScrollBars();
+    followedRadius = -1;
+    followViewport();
+    viewport()->update();
+}
+
+void BoardView::updateScrollBars() {
+    const QSize area = viewport()->size();
+    horizontalScrollBar()->setRange(0, int(qMax<int64_t>(0, contentWidth() - area.width())));
+    verticalScrollBar()->setRange(0, int(qMax<int64_t>(0, contentHeight() - area.height())));
+    horizontalScrollBar()->setPageStep(area.width());
+    verticalScrollBar()->setPageStep(area.height());
+    horizontalScrollBar()->setSingleStep(cellSize);
+    verticalScrollBar()->setSingleStep(cellSize);
+}
+
+void BoardView::setZoom(int size) {
+    size = qBound(minCellSize, size, maxCellSize);
+    if (size == cellSize) return;
+
+    // 記下畫面中央是哪個位置，縮放後捲回同一個地方
+    const QSize area = viewport()->size();
+    double centerX = (horizontalScrollBar()->value() + area.width() / 2.0) / cellSize;
+    double centerY = (verticalScrollBar()->value() + area.height() / 2.0) / cellSize;
+    cellSize = size;
+    boardResized();
+    horizontalScrollBar()->setValue(qRound(centerX * cellSize - viewport()->width() / 2.0));
+    verticalScrollBar()->setValue(qRound(centerY * cellSize - viewport()->height() / 2.0));
+    viewport()->update();
+    emit zoomChanged(cellSize);
+}
+
+void BoardView::zoomBy(int steps) {
+    setZoom(cellSize + steps * qMax(2, cellSize / 5));  // 格子越大每一級放大越多
+}
+
+void BoardView::centerOn(int row, int col) {
+    horizontalScrollBar()->setValue(int((int64_t(col - originCol) * cellSize) + cellSize / 2 - viewport()->width() / 2));
+    verticalScrollBar()->setValue(int((int64_t(row - originRow) * cellSize) + cellSize / 2 - viewport()->height() / 2));
+}
+
+void BoardView::resizeEvent(QResizeEvent *event) {
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+    followViewport();
+}
+
+void BoardView::scrollContentsBy(int dx, int dy) {
+    // 上一個畫面搬過去就好，Qt 只會對新露出來的長條送 paintEvent
+    viewport()->scroll(dx, dy);
+    if (profiling()) {
+        viewport()->update(overlayRect().translated(dx, dy));  // 量測結果固定在左上角，不能跟著搬
+        refreshOverlay();
+    }
+    followViewport();
+}
+
+void BoardView::followViewport() {
+    if (!chunked) return;
+
+    // 畫面中央所在的區塊換了 (或畫面變大) 才移動活動範圍
+    const QSize area = viewport()->size();
+    int row = originRow + (verticalScrollBar()->value() + area.height() / 2) / cellSize;
+    int col = originCol + (horizontalScrollBar()->value() + area.width() / 2) / cellSize;
+    int visibleTiles = (qMax(area.width(), area.height()) / cellSize) / ChunkedBoard::tileSize + 1;
+    int radius = qMax(ChunkedBoard::defaultRadius, visibleTiles / 2 + 2);
+    int tileRow = row >> ChunkedBoard::tileShift;
+    int tileCol = col >> ChunkedBoard::tileShift;
+    if (tileRow == followedRow && tileCol == followedCol && radius == followedRadius) return;
+
+    followedRow = tileRow;
+    followedCol = tileCol;
+    followedRadius = radius;
+    chunked->keepAround(row, col, radius);
+    if (!chunked->changedCells().empty()) viewport()->update();  // 之前停在範圍外的展開繼續了
+}
+
+QRect BoardView::cellRect(int row, int col) const {
+    return QRect(int(int64_t(col - originCol) * cellSize - horizontalScrollBar()->value()),
+                 int(int64_t(row - originRow) * cellSize - verticalScrollBar()->value()), cellSize, cellSize);
+}
+
+bool BoardView::positionAt(const QPoint &pos, int *row, int *col) const {
+    int x = pos.x() + horizontalScrollBar()->value();
+    int y = pos.y() + verticalScrollBar()->value();
+    if (x < 0 || y < 0 || x >= contentWidth() || y >= contentHeight()) return false;
+    *row = originRow + y / cellSize;
+    *col = originCol + x / cellSize;
+    return true;
+}
+
+void BoardView::updateCell(int row, int col) {
+    viewport()->update(cellRect(row, col));
+}
+
+void BoardView::setHint(int index, bool mine) {
+    if (chunked) return;
+    if (hintIndex >= 0) updateCell(board->rowOf(hintIndex), board->colOf(hintIndex));
+    hintIndex = index;
+    hintMine = mine;
+    if (hintIndex >= 0) updateCell(board->rowOf(hintIndex), board->colOf(hintIndex));
+}
+
+void BoardView::setProbabilities(const ProbabilityEngine *probabilities) {
+    this->probabilities = chunked ? nullptr : probabilities;
+    viewport()->update();  // 機率每一步都可能整片改變，直接重畫整個畫面
+}
+
+void BoardView::updateRuns() {
+    // 每個格子各自 update() 會讓 Qt 一個一個合併出很複雜的 QRegion，
+    // 外框又會把中間沒變的大片格子一起重畫 (例如對角線上的兩塊)：
+    // 先依照列排好，同一列相連的格子合成一段，一次用 setRects 組成 QRegion
+    // (由上到下、同一列的矩形一樣高，正好符合 setRects 的要求)
+    const QSize area = viewport()->size();
+    const int firstRow = originRow + verticalScrollBar()->value() / cellSize;
+    const int lastRow = originRow + (verticalScrollBar()->value() + area.height() - 1) / cellSize;
+    const int firstCol = originCol + horizontalScrollBar()->value() / cellSize;
+    const int lastCol = originCol + (horizontalScrollBar()->value() + area.width() - 1) / cellSize;
+    std::sort(batchCells.begin(), batchCells.end(), [](const QPoint &a, const QPoint &b) {
+        return a.y() != b.y() ? a.y() < b.y() : a.x() < b.x();
+    });
+    runRects.clear();
+    for (size_t i = 0; i < batchCells.size();) {
+        const QPoint start = batchCells[i];
+        int end = start.x();
+        for (++i; i < batchCells.size() && batchCells[i].y() == start.y() && batchCells[i].x() <= end + 1; ++i) {
+            end = qMax(end, batchCells[i].x());
+        }
+        // 畫面外的段直接跳過 (範圍可能比畫面大很多)
+        if (start.y() < firstRow || start.y() > lastRow || end < firstCol || start.x() > lastCol) continue;
+        runRects.push_back(cellRect(start.y(), qMax(start.x(), firstCol)).united(cellRect(start.y(), qMin(end, lastCol))));
+    }
+    batchCells.clear();
+    if (runRects.empty()) return;
+    QRegion region;
+    region.setRects(runRects.data(), int(runRects.size()));
+    viewport()->update(region);
+}
+
+void BoardView::updateCells(const std::vector<int> &cells) {
+    if (hintIndex >= 0 && !cells.empty()) setHint(-1);  // 盤面變了，提示可能已經不對
+    m_lastBatchSize = int(cells.size());
+    if (m_lastBatchSize <= smallBatch) {
+        // 只有幾格 (點數字、插旗子、重新開始前零星的旗子)：各自重畫就好
+        for (int index : cells) {
+            updateCell(board->rowOf(index), board->colOf(index));
+        }
+    } else {
+        for (int index : cells) {
+            batchCells.emplace_back(board->colOf(index), board->rowOf(index));
+        }
+        updateRuns();
+    }
+    if (clickPending && m_lastBatchSize > 0) paintPending = true;
+    emit batchApplied(m_lastBatchSize);
+}
+
+void BoardView::updatePositions(const std::vector<ChunkedBoard::Position> &cells) {
+    m_lastBatchSize = int(cells.size());
+    if (m_lastBatchSize <= smallBatch) {
+        for (const ChunkedBoard::Position &p : cells) {
+            updateCell(p.row, p.col);
+        }
+    } else {
+        for (const ChunkedBoard::Position &p : cells) {
+            batchCells.emplace_back(p.col, p.row);
+        }
+        updateRuns();
+    }
+    if (clickPending && m_lastBatchSize > 0) paintPending = true;
+    emit batchApplied(m_lastBatchSize);
+}
+
+void BoardView::paintEvent(QPaintEvent *event) {
+    QElapsedTimer paintTimer;
+    paintTimer.start();
+
+    QPainter painter(viewport());
+    faces.setCellSize(cellSize, devicePixelRatioF());  // 縮放或換到不同縮放比例的螢幕才會重畫外觀
+
+    // 只畫需要更新的區域裡面、而且在畫面上的格子 (區域裡的矩形各自畫，不畫整個外框)
+    const int x = horizontalScrollBar()->value();
+    const int y = verticalScrollBar()->value();
+    for (const QRect &dirty : event->region()) {
+        if (int64_t(dirty.right()) + x >= contentWidth() || int64_t(dirty.bottom()) + y >= contentHeight()) {
+            painter.fillRect(dirty, palette().window());  // 盤面比畫面小的地方
+        }
+        int firstRow = originRow + qMax(0, dirty.top() + y) / cellSize;
+        int lastRow = originRow + int(qMin<int64_t>(contentHeight() - 1, dirty.bottom() + y) / cellSize);
+        int firstCol = originCol + qMax(0, dirty.left() + x) / cellSize;
+        int lastCol = originCol + int(qMin<int64_t>(contentWidth() - 1, dirty.right() + x) / cellSize);
+
+        for (int i = firstRow; i <= lastRow; ++i) {
+            for (int j = firstCol; j <= lastCol; ++j) {
+                drawCell(painter, i, j);
+            }
+        }
+    }
+
+    if (paintPending && profiling()) {
+        profiler->record(LatencyProfiler::Paint, paintTimer.nsecsElapsed());
+        profiler->record(LatencyProfiler::ClickToPaint, clickTimer.nsecsElapsed());
+    }
+    paintPending = false;
+    clickPending = false;
+
+    if (profiling() && event->rect().intersects(overlayRect())) {
+        drawOverlay(painter);
+    }
+}
+
+QRect BoardView::overlayRect() const {
+    return QRect(0, 0, 330, 8 + LatencyProfiler::PhaseCount * 14).intersected(viewport()->rect());
+}
+
+void BoardView::refreshOverlay() {
+    viewport()->update(overlayRect());
+}
+
+void BoardView::drawOverlay(QPainter &painter) {
+    QFont font("monospace");
+    font.setStyleHint(QFont::Monospace);
+    font.setPixelSize(11);
+    painter.setFont(font);
+    painter.fillRect(overlayRect(), QColor(0, 0, 0, 170));
+    painter.setPen(Qt::white);
+
+    int y = 4;
+    for (const QString &line : profiler->summaryLines()) {
+        painter.drawText(QRect(6, y, 330, 14), Qt::AlignLeft | Qt::AlignVCenter, line);
+        y += 14;
+    }
+}
+
+void BoardView::drawCell(QPainter &painter, int row, int col) {
+    QRect rect = cellRect(row, col);
+    const uint8_t bits = cellBits(row, col);
+    const int face = CellFaceCache::faceOf(bits);
+    faces.draw(painter, rect.topLeft(), face);
+    if (face != CellFaceCache::Covered || chunked) return;
+
+    // 熱圖和提示只會畫在沒打開、沒插旗子的格子上
+    if (probabilities) {
+        drawProbability(painter, rect, probabilities->probability(board->index(row, col)));
+    }
+    if (board->index(row, col) == hintIndex) {
+        painter.setPen(QPen(hintMine ? QColor(211, 47, 47) : QColor(56, 142, 60), 3));
+        painter.drawRect(rect.adjusted(2, 2, -2, -2));
+    }
+}
+
+void BoardView::drawProbability(QPainter &painter, const QRect &rect, float probability) {
+    if (probability < 0) return;
+
+    // 安全是綠色，地雷是紅色，中間依比例混合
+    QColor color(int(56 + (211 - 56) * probability), int(142 + (47 - 142) * probability),
+                 int(60 + (47 - 60) * probability), 120);
+    painter.fillRect(rect.adjusted(1, 1, -1, -1), color);
+    if (cellSize < 20) return;  // 格子太小放不下數字，只留顏色
+
+    painter.save();
+    QFont font = painter.font();
+    font.setPixelSize(10);
+    painter.setFont(font);
+    painter.setPen(Qt::black);
+    painter.drawText(rect, Qt::AlignCenter, QString::number(qRound(probability * 100)));
+    painter.restore();
+}
+
+void BoardView::wheelEvent(QWheelEvent *event) {
+    if (event->modifiers() & Qt::ControlModifier) { // Ctrl + 滾輪縮放
+        int steps = event->angleDelta().y() / 120;
+        if (steps != 0) zoomBy(steps);
+        event->accept();
+        return;
+    }
+    QAbstractScrollArea::wheelEvent(event);
+}
+
+void BoardView::mousePressEvent(QMouseEvent *event) {
+    pressed = positionAt(event->position().toPoint(), &pressedRow, &pressedCol);
+    const Qt::MouseButtons both = Qt::LeftButton | Qt::RightButton;
+    if (event->button() == Qt::MiddleButton || (event->buttons() & both) == both) chording = true;
+    QAbstractScrollArea::mousePressEvent(event);
+}
+
+void BoardView::mouseReleaseEvent(QMouseEvent *event) {
+    clickTimer.start();
+    clickPending = profiling();
+
+    // 跟按鈕一樣：在同一個格子按下又放開才算點擊
+    int row, col;
+    bool onBoard = positionAt(event->position().toPoint(), &row, &col);
+    if (clickPending) profiler->record(LatencyProfiler::HitTest, clickTimer.nsecsElapsed());
+    bool sameCell = onBoard && pressed && row == pressedRow && col == pressedCol;
+    pressed = false;
+    if (chording) { // 放開第一個鍵時送出，之後放開其他鍵不再算點擊
+        if (!(event->buttons() & (Qt::LeftButton | Qt::RightButton | Qt::MiddleButton))) chording = false;
+        if (!sameCell) return;
+        if (chunked) {
+            emit positionChorded(row, col);
+        } else {
+            emit cellChorded(board->index(row, col));
+        }
+        return;
+    }
+    if (!sameCell) {
+        QAbstractScrollArea::mouseReleaseEvent(event);
+        return;
+    }
+
+    if (chunked) {
+        if (event->button() == Qt::LeftButton) {
+            emit positionClicked(row, col);
+        } else if (event->button() == Qt::RightButton) {
+            emit positionRightClicked(row, col);
+        }
+        return;
+    }
+    int index = board->index(row, col);
+    if (event->button() == Qt::LeftButton) {
+        emit cellClicked(index);
+    } else if (event->button() == Qt::RightButton) {
+        emit cellRightClicked(index);
+    }
+}
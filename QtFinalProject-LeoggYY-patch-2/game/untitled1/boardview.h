@@ -0,0 +1,126 @@
+﻿#ifndef BOARDVIEW_H
+#define BOARDVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QRect>
+#include <QElapsedTimer>
+#include <vector>
+#include "cellfacecache.h"
+#include "chunkedboard.h"
+#include "minesweeperboard.h"
+#include "probabilityengine.h"
+#include "latencyprofiler.h"
+
+// 用一個元件畫出整個盤面，取代每個格子一個 QPushButton
+// 盤面比視窗大時可以捲動 (捲軸、滾輪) 和縮放 (Ctrl + 滾輪)，只畫看得到的格子；
+// 捲動時把上一個畫面直接搬過去 (viewport()->scroll)，只補畫新露出來的部分。
+class BoardView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit BoardView(const MinesweeperBoard *board, QWidget *parent = nullptr);
+    // 超大盤面或無限模式 (ChunkedBoard)：點擊送出 positionClicked，捲動時會呼叫 keepAround
+    explicit BoardView(ChunkedBoard *chunked, QWidget *parent = nullptr);
+
+    void boardResized();  // 盤面大小改變後重新計算元件大小
+    void updateCell(int row, int col);  // 只重畫一個格子
+    // 一次更新一批改變的格子 (MinesweeperBoard::index)：算出它們的範圍，只排一次重畫
+    void updateCells(const std::vector<int> &cells);
+    void updatePositions(const std::vector<ChunkedBoard::Position> &cells);  // 同 updateCells (ChunkedBoard)
+    int lastBatchSize() const { return m_lastBatchSize; }  // 上一批更新了幾個格子
+
+    QRect cellRect(int row, int col) const;  // 格子在畫面上的位置 (已經扣掉捲動的距離)
+
+    int zoom() const { return cellSize; }
+    void setZoom(int size);  // 格子大小 (minCellSize ~ maxCellSize)，畫面中央的格子保持不動
+    void zoomBy(int steps);  // 放大 (正) 或縮小 (負) 幾級，Ctrl + 滾輪和 +/- 鍵用
+    void centerOn(int row, int col);
+
+    // 提示 (H)：把一個格子框起來，綠色是安全、紅色是地雷；-1 代表不顯示
+    // 盤面一有改變 (updateCells) 提示就會消失
+    void setHint(int index, bool mine = false);
+
+    // 機率熱圖 (P)：沒打開的格子依照是地雷的機率上色；nullptr 代表不顯示
+    void setProbabilities(const ProbabilityEngine *probabilities);
+
+    // 效能量測：記錄 hit-test / paint / click-to-paint，啟用時在左上角畫出 p50/p99
+    void setProfiler(LatencyProfiler *profiler) { this->profiler = profiler; }
+    void refreshOverlay();  // 重畫量測結果那一塊
+
+    static constexpr int minCellSize = 8;
+    static constexpr int maxCellSize = 60;
+
+signals:
+    // 參數是 MinesweeperBoard::index，點擊時直接算出來，不用再查表
+    void cellClicked(int index);       // 左鍵點擊
+    void cellRightClicked(int index);  // 右鍵點擊
+    void cellChorded(int index);       // 中鍵，或左右鍵一起按 (快速打開)
+    void positionClicked(int row, int col);       // 同上 (ChunkedBoard)
+    void positionRightClicked(int row, int col);
+    void positionChorded(int row, int col);
+    void batchApplied(int cells);      // 每次 updateCells 之後送出這批的格子數
+    void zoomChanged(int cellSize);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private:
+    static constexpr int defaultCellSize = 30;  // 格子大小
+    static constexpr int smallBatch = 16;  // 這個數量以下逐格重畫，超過就合併成每一列的區段
+    static constexpr int endlessSpan = 1 << 20;  // 無限模式可以捲動的範圍 (格子)，以 (0, 0) 為中心
+
+    void setupView();
+    int64_t contentWidth() const { return int64_t(boardCols()) * cellSize; }
+    int64_t contentHeight() const { return int64_t(boardRows()) * cellSize; }
+    int boardRows() const { return chunked ? (chunked->endless() ? endlessSpan : chunked->rows()) : board->rows(); }
+    int boardCols() const { return chunked ? (chunked->endless() ? endlessSpan : chunked->cols()) : board->cols(); }
+    uint8_t cellBits(int row, int col) const {
+        return chunked ? chunked->cell(row, col) : board->cell(board->index(row, col));
+    }
+    bool positionAt(const QPoint &pos, int *row, int *col) const;  // 畫面座標轉換成格子，不在盤面上回傳 false
+    void updateScrollBars();
+    void updateRuns();  // 重畫 batchCells 裡的格子 (會清空 batchCells)
+    void followViewport();  // 讓 ChunkedBoard 的活動範圍跟著畫面 (展開只在畫面附近進行)
+    void drawCell(QPainter &painter, int row, int col);
+    void drawProbability(QPainter &painter, const QRect &rect, float probability);  // 熱圖上的一格 (百分比)
+    bool profiling() const { return profiler && profiler->isEnabled(); }
+    QRect overlayRect() const;
+    void drawOverlay(QPainter &painter);
+
+    const MinesweeperBoard *board = nullptr;
+    ChunkedBoard *chunked = nullptr;
+    int originRow = 0;  // 捲動位置 0 對應的格子 (無限模式是 -endlessSpan / 2)
+    int originCol = 0;
+    int cellSize = defaultCellSize;
+    CellFaceCache faces;  // 每種格子大小的外觀只畫一次
+    int followedRow = 0;  // 上一次 keepAround 的區塊和範圍
+    int followedCol = 0;
+    int followedRadius = -1;
+
+    int pressedRow = -1;  // 按下滑鼠時的格子，放開時在同一格才算點擊
+    int pressedCol = -1;
+    bool pressed = false;
+    bool chording = false;  // 按了中鍵或左右鍵一起按，要等所有鍵都放開才結束
+    int m_lastBatchSize = 0;
+    std::vector<QPoint> batchCells;  // 一大批要重畫的格子 (x 是欄、y 是列)，留著重複使用
+    std::vector<QRect> runRects;
+    int hintIndex = -1;
+    bool hintMine = false;
+    const ProbabilityEngine *probabilities = nullptr;
+
+    LatencyProfiler *profiler = nullptr;
+    QElapsedTimer clickTimer;   // 從放開滑鼠開始計時
+    bool clickPending = false;  // 這次點擊還沒畫出來
+    bool paintPending = false;  // 這次點擊已經排了重畫，下一次 paintEvent 要記錄
+};
+
+#endif // BOARDVIEW_H
@@ -0,0 +1,99 @@
+﻿#include "cellfacecache.h"
+#include <QtMath>
+#include "minesweeperboard.h"
+
+namespace {
+// 數字 1~8 的顏色
+const QColor numberColors[9] = {
+    Qt::black, QColor(25, 118, 210), QColor(56, 142, 60), QColor(211, 47, 47),
+    QColor(123, 31, 162), QColor(255, 143, 0), QColor(0, 151, 167),
+    QColor(66, 66, 66), QColor(158, 158, 158)
+};
+}
+
+int CellFaceCache::faceOf(uint8_t cell) {
+    if (!(cell & MinesweeperBoard::RevealedBit)) return (cell & MinesweeperBoard::FlagBit) ? Flagged : Covered;
+    if (cell & MinesweeperBoard::MineBit) return Mine;
+    return Opened + (cell & MinesweeperBoard::CountMask);
+}
+
+void CellFaceCache::setCellSize(int size, qreal devicePixelRatio) {
+    if (size == this->size && devicePixelRatio == ratio && !current.isNull()) return;
+    this->size = size;
+    ratio = devicePixelRatio;
+
+    const quint64 key = keyOf(size, ratio);
+    auto it = atlases.constFind(key);
+    if (it != atlases.constEnd()) {
+        current = *it;
+        recent.removeOne(key);
+        recent.append(key);
+        return;
+    }
+
+    current = QPixmap(qCeil(FaceCount * size * ratio), qCeil(size * ratio));
+    current.setDevicePixelRatio(ratio);
+    current.fill(Qt::transparent);
+    QPainter painter(&current);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    for (int face = 0; face < FaceCount; ++face) {
+        paintFace(painter, QRect(face * size, 0, size, size), face);
+    }
+    painter.end();
+    atlases.insert(key, current);
+    recent.append(key);
+    while (recent.size() > maxSizes) {
+        atlases.remove(recent.takeFirst());  // 最久沒用的大小
+    }
+}
+
+void CellFaceCache::draw(QPainter &painter, const QPoint &topLeft, int face) const {
+    const qreal pixels = size * ratio;
+    painter.drawPixmap(QPointF(topLeft), current, QRectF(face * pixels, 0, pixels, pixels));
+}
+
+void CellFaceCache::clear() {
+    atlases.clear();
+    recent.clear();
+    current = QPixmap();
+    size = 0;
+}
+
+void CellFaceCache::paintFace(QPainter &painter, const QRect &rect, int face) {
+    QFont font = painter.font();
+    font.setBold(true);
+
+    if (face == Covered || face == Flagged) {
+        // 還沒打開：畫成凸起的按鈕
+        painter.fillRect(rect, QColor(225, 225, 225));
+        painter.setPen(Qt::white);
+        painter.drawLine(rect.topLeft(), rect.topRight());
+        painter.drawLine(rect.topLeft(), rect.bottomLeft());
+        painter.setPen(QColor(140, 140, 140));
+        painter.drawLine(rect.bottomLeft(), rect.bottomRight());
+        painter.drawLine(rect.topRight(), rect.bottomRight());
+        if (face == Flagged) {
+            font.setPixelSize(qMax(6, rect.height() / 2));
+            painter.setFont(font);
+            painter.drawText(rect, Qt::AlignCenter, "🚩");
+        }
+        return;
+    }
+
+    // 已經打開：平的格子加上內容
+    painter.fillRect(rect, QColor(245, 245, 245));
+    painter.setPen(QColor(200, 200, 200));
+    painter.drawRect(rect.adjusted(0, 0, -1, -1));
+
+    if (face == Mine) {
+        font.setPixelSize(qMax(6, rect.height() / 2));
+        painter.setFont(font);
+        painter.drawText(rect, Qt::AlignCenter, "💣");
+    } else if (face > Opened) {
+        int value = face - Opened;
+        font.setPixelSize(qMax(6, rect.height() * 3 / 5));
+        painter.setFont(font);
+        painter.setPen(numberColors[value]);
+        painter.drawText(rect, Qt::AlignCenter, QString::number(value));
+    }
+}
@@ -0,0 +1,49 @@
+﻿#ifndef CELLFACECACHE_H
+#define CELLFACECACHE_H
+
+#include <QHash>
+#include <QList>
+#include <QPainter>
+#include <QPixmap>
+#include <QRect>
+#include <cstdint>
+
+// 格子的外觀 (沒打開的按鈕、旗子、數字 1~8、地雷) 事先畫成一張圖，一種外觀一格，
+// 依照 (外觀, 格子大小) 取用。畫盤面時每個格子只是一次 drawPixmap，
+// 不用每次建立 QString、排版文字，也不用讓 Qt 從備用字型裡找 emoji。
+class CellFaceCache
+{
+public:
+    enum Face {
+        Covered,   // 還沒打開
+        Flagged,   // 插了旗子
+        Opened,    // 打開的空白格子，Opened + n 是數字 n
+        Mine = Opened + 9,
+        FaceCount
+    };
+
+    static int faceOf(uint8_t cell);  // MinesweeperBoard::CellBits 轉換成外觀
+
+    // 換成這個格子大小 (和螢幕縮放比例)，最近用過的 maxSizes 種大小直接拿出來用
+    void setCellSize(int size, qreal devicePixelRatio = 1.0);
+    int cellSize() const { return size; }
+    void draw(QPainter &painter, const QPoint &topLeft, int face) const;
+    void clear();  // 丟掉所有大小的圖
+    int cachedSizes() const { return atlases.size(); }
+
+    // 直接用 fillRect / drawText 畫一個格子，建立快取時用，也是效能比較的對照組
+    static void paintFace(QPainter &painter, const QRect &rect, int face);
+
+private:
+    static constexpr int maxSizes = 4;  // 一直縮放會畫出很多種大小，只留最近用過的幾種
+
+    static quint64 keyOf(int size, qreal ratio) { return (quint64(size) << 32) | quint64(qRound(ratio * 100)); }
+
+    QHash<quint64, QPixmap> atlases;
+    QList<quint64> recent;  // atlases 的 key，最近用過的在最後面
+    QPixmap current;  // 目前大小的圖 (QPixmap 是隱式共用的，不會複製像素)
+    int size = 0;
+    qreal ratio = 1.0;
+};
+
+#endif // CELLFACECACHE_H
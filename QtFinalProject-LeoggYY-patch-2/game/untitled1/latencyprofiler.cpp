@@ -0,0 +1,111 @@
+﻿#include "latencyprofiler.h"
+#include <QFile>
+#include <QTextStream>
+#include <QtAlgorithms>
+#include <cmath>
+
+LatencyProfiler::LatencyProfiler()
+{
+    enabled = !qEnvironmentVariableIsEmpty("MINESWEEPER_PROFILE");  // 設定環境變數就一開始就啟用
+}
+
+const char *LatencyProfiler::phaseName(Phase phase) {
+    switch (phase) {
+    case HitTest: return "hit-test";
+    case Rules: return "rules";
+    case FloodFill: return "flood-fill";
+    case UiUpdate: return "ui-update";
+    case Paint: return "paint";
+    case ClickToPaint: return "click-to-paint";
+    default: return "?";
+    }
+}
+
+QString LatencyProfiler::formatNanos(qint64 nanos) {
+    if (nanos < 1000) return QString("%1ns").arg(nanos);
+    if (nanos < 1000000) return QString("%1us").arg(nanos / 1000.0, 0, 'f', 1);
+    return QString("%1ms").arg(nanos / 1000000.0, 0, 'f', 2);
+}
+
+int LatencyProfiler::bucketOf(qint64 nanos) {
+    if (nanos < linearBuckets) return int(qMax<qint64>(nanos, 0));
+    int exponent = 63 - qCountLeadingZeroBits(quint64(nanos));  // 最高位元的位置 (>= 4)
+    int sub = int(nanos >> (exponent - 3)) & (subBuckets - 1);
+    return qMin(linearBuckets + (exponent - 4) * subBuckets + sub, bucketCount - 1);
+}
+
+qint64 LatencyProfiler::bucketLow(int bucket) {
+    if (bucket < linearBuckets) return bucket;
+    int exponent = (bucket - linearBuckets) / subBuckets + 4;
+    int sub = (bucket - linearBuckets) % subBuckets;
+    return qint64(subBuckets + sub) << (exponent - 3);
+}
+
+void LatencyProfiler::record(Phase phase, qint64 nanos) {
+    if (!enabled) return;
+    Histogram &histogram = histograms[phase];
+    ++histogram.buckets[bucketOf(nanos)];
+    ++histogram.count;
+    histogram.max = qMax(histogram.max, nanos);
+}
+
+void LatencyProfiler::reset() {
+    histograms = {};
+}
+
+qint64 LatencyProfiler::percentile(Phase phase, double p) const {
+    const Histogram &histogram = histograms[phase];
+    if (histogram.count == 0) return 0;
+
+    quint64 rank = qMax<quint64>(1, quint64(std::ceil(p * histogram.count)));
+    quint64 seen = 0;
+    for (int i = 0; i < bucketCount; ++i) {
+        seen += histogram.buckets[i];
+        if (seen >= rank) {
+            // 回傳這一格的中間值 (不超過看過的最大值)
+            qint64 mid = (bucketLow(i) + bucketLow(i + 1)) / 2;
+            return qMin(mid, histogram.max);
+        }
+    }
+    return histogram.max;
+}
+
+QStringList LatencyProfiler::summaryLines() const {
+    QStringList lines;
+    for (int i = 0; i < PhaseCount; ++i) {
+        Phase phase = Phase(i);
+        lines << QString("%1  p50 %2  p99 %3  (%4)")
+                     .arg(phaseName(phase), -14)
+                     .arg(formatNanos(percentile(phase, 0.50)), 8)
+                     .arg(formatNanos(percentile(phase, 0.99)), 8)
+                     .arg(count(phase));
+    }
+    return lines;
+}
+
+bool LatencyProfiler::writeCsv(const QString &path) const {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+
+    QTextStream out(&file);
+    // 第一段：每個階段的統計
+    out << "phase,count,p50_ns,p90_ns,p99_ns,max_ns\n";
+    for (int i = 0; i < PhaseCount; ++i) {
+        Phase phase = Phase(i);
+        out << phaseName(phase) << ',' << count(phase) << ','
+            << percentile(phase, 0.50) << ',' << percentile(phase, 0.90) << ','
+            << percentile(phase, 0.99) << ',' << histograms[i].max << '\n';
+    }
+
+    // 第二段：原始直方圖 (只列出有資料的格子)
+    out << "\nphase,bucket_low_ns,bucket_high_ns,samples\n";
+    for (int i = 0; i < PhaseCount; ++i) {
+        const Histogram &histogram = histograms[i];
+        for (int b = 0; b < bucketCount; ++b) {
+            if (histogram.buckets[b] == 0) continue;
+            out << phaseName(Phase(i)) << ',' << bucketLow(b) << ',' << bucketLow(b + 1) << ','
+                << histogram.buckets[b] << '\n';
+        }
+    }
+    return true;
+}
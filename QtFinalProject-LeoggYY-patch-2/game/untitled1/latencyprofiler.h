@@ -0,0 +1,59 @@
+﻿#ifndef LATENCYPROFILER_H
+#define LATENCYPROFILER_H
+
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+#include <array>
+
+// 記錄每一次點擊各階段花的時間 (奈秒)，用直方圖算出 p50 / p99
+// 直方圖每個 2 的次方再分 8 格，誤差在 12.5% 以內，記錄一次是 O(1)
+class LatencyProfiler
+{
+public:
+    enum Phase {
+        HitTest,       // 滑鼠座標轉換成格子
+        Rules,         // 遊戲規則 (不含展開空白區域)
+        FloodFill,     // 展開空白區域
+        UiUpdate,      // 通知畫面要重畫哪些格子
+        Paint,         // paintEvent
+        ClickToPaint,  // 放開滑鼠到畫完的總時間
+        PhaseCount
+    };
+
+    LatencyProfiler();
+
+    bool isEnabled() const { return enabled; }
+    void setEnabled(bool on) { enabled = on; }
+
+    void record(Phase phase, qint64 nanos);
+    void reset();
+
+    quint64 count(Phase phase) const { return histograms[phase].count; }
+    qint64 percentile(Phase phase, double p) const;  // p 介於 0~1
+
+    QStringList summaryLines() const;  // 畫在畫面上的文字
+    bool writeCsv(const QString &path) const;  // 輸出每個階段的百分位數和直方圖
+
+    static const char *phaseName(Phase phase);
+    static QString formatNanos(qint64 nanos);
+
+private:
+    static constexpr int linearBuckets = 16;  // 0~15 奈秒各一格
+    static constexpr int subBuckets = 8;       // 之後每個 2 的次方分 8 格
+    static constexpr int bucketCount = linearBuckets + 60 * subBuckets;
+
+    struct Histogram {
+        std::array<quint64, bucketCount> buckets{};
+        quint64 count = 0;
+        qint64 max = 0;
+    };
+
+    static int bucketOf(qint64 nanos);
+    static qint64 bucketLow(int bucket);
+
+    bool enabled = false;
+    std::array<Histogram, PhaseCount> histograms;
+};
+
+#endif // LATENCYPROFILER_H
@@ -9,10 +9,16 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    boardview.cpp \
+    cellfacecache.cpp \
+    latencyprofiler.cpp \
     main.cpp \
     widget.cpp
 
 HEADERS += \
+    boardview.h \
+    cellfacecache.h \
+    latencyprofiler.h \
     widget.h
 
 # Default rules for deployment.
@@ -22,3 +28,5 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 RESOURCES += \
     resources.qrc
+
+include(../engine/engine.pri)
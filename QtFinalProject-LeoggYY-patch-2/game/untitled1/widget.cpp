@@ -12,9 +12,22 @@
 #include <QSize>
 #include <QPoint>
 #include <QDebug>
+#include <QStatusBar>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <limits>
 
 Widget::Widget(QWidget *parent)
-    : QMainWindow(parent), layout(new QGridLayout), grid(rows, QVector<int>(cols, 0)), flags(rows, QVector<bool>(cols, false)) // flags 用來追蹤每個格子是否放置了旗子
+    : QMainWindow(parent), board(rows, cols, mineCount), generator(QThread::idealThreadCount() - 1)  // 留一個核心給畫面
 {
     // 音效初始化
     clickSound.setSource(QUrl::fromLocalFile(":/sound/click.wav"));
@@ -27,6 +40,30 @@ Widget::Widget(QWidget *parent)
     winSound.setVolume(100);
 
 
+    overlayTimer.setInterval(500);
+    connect(&overlayTimer, &QTimer::timeout, this, [this]() {
+        if (boardView) boardView->refreshOverlay();
+    });
+    setProfiling(profiler.isEnabled());  // MINESWEEPER_PROFILE 環境變數
+
+    bool ok = false;
+    int undoLimit = qEnvironmentVariableIntValue("MINESWEEPER_UNDO_MB", &ok);  // 悔棋記錄的記憶體上限 (MB)
+    if (ok && undoLimit > 0) journal.setMemoryLimit(size_t(undoLimit) << 20);
+
+    replayTimer.setSingleShot(true);
+    connect(&replayTimer, &QTimer::timeout, this, &Widget::replayStep);
+
+    // 背景執行緒找到 (或放棄) 盤面時排進畫面的執行緒處理，不在背景碰盤面
+    generator.setFoundCallback([this](const NoGuessGenerator::Config &config, bool found) {
+        QMetaObject::invokeMethod(this, [this, config, found]() {
+            if (found) {
+                noGuessFound(config);
+            } else {
+                noGuessFailed(config);
+            }
+        }, Qt::QueuedConnection);
+    });
+
     centralWidget = new QWidget(this);
     mainLayout = new QVBoxLayout(centralWidget);
 
@@ -37,13 +74,17 @@ Widget::Widget(QWidget *parent)
 }
 
 
-Widget::~Widget() {}
+Widget::~Widget() {
+    generator.stop();  // 先停下背景執行緒，之後不會再排事件給已經刪掉的視窗
+    chunkedMode = false;
+    updateSwapFile();  // 關掉並刪掉無限模式的暫存檔
+}
 
 void Widget::theDifficultyWidget(){
+    stopReplay();
     qDeleteAll(findChildren<QPushButton*>());
-
-    flagCount = 0;
-    cerrectCount = 0;
+    delete boardView;
+    boardView = nullptr;
 
     rowsInput = new QLineEdit(this);
     colsInput = new QLineEdit(this);
@@ -57,26 +98,44 @@ void Widget::theDifficultyWidget(){
     QPushButton *normalButton = new QPushButton("normal", this);
     QPushButton *hardButton = new QPushButton("hard", this);
     QPushButton *customizeButton = new QPushButton("customize", this);
+    QPushButton *endlessButton = new QPushButton("endless", this);
 
     connect(easyButton, &QPushButton::clicked, this, &Widget::setEasy);
     connect(normalButton, &QPushButton::clicked, this, &Widget::setNormal);
     connect(hardButton, &QPushButton::clicked, this, &Widget::setHard);
     connect(customizeButton, &QPushButton::clicked, this, &Widget::setCustomise);
+    connect(endlessButton, &QPushButton::clicked, this, &Widget::setEndless);
 
     QHBoxLayout *inputLayout = new QHBoxLayout();
     inputLayout->addWidget(rowsInput);
     inputLayout->addWidget(colsInput);
     inputLayout->addWidget(mineCountInput);
 
+    QCheckBox *noGuessBox = new QCheckBox("不用猜的盤面", this);
+    noGuessBox->setChecked(noGuess);
+    connect(noGuessBox, &QCheckBox::toggled, this, [this](bool checked) {
+        noGuess = checked;
+        if (noGuess) {
+            startNoGuess();
+        } else {
+            cancelNoGuess();
+            generator.stop();
+        }
+    });
+
     QGridLayout *buttonLayout = new QGridLayout();
     buttonLayout->addWidget(easyButton, 0, 0);
     buttonLayout->addWidget(normalButton, 0, 1);
     buttonLayout->addWidget(hardButton, 0, 2);
     buttonLayout->addWidget(customizeButton, 0, 3);
+    buttonLayout->addWidget(endlessButton, 0, 4);
+    buttonLayout->addWidget(noGuessBox, 1, 0, 1, 5);
 
     mainLayout->addLayout(inputLayout);
     mainLayout->addLayout(buttonLayout);
 
+    // 玩家還在選難度的時候就先開始找，選好時通常已經準備好了
+    if (noGuess) startNoGuess();
 
 }
 
@@ -84,6 +143,7 @@ void Widget::setEasy(){
     rows = 10;
     cols = 10;
     mineCount = 10;
+    chunkedMode = false;
     resetGrid();
 }
 
@@ -91,6 +151,7 @@ void Widget::setNormal(){
     rows = 15;
     cols = 15;
     mineCount = 60;
+    chunkedMode = false;
     resetGrid();
 }
 
@@ -98,240 +159,318 @@ void Widget::setHard(){
     rows = 20;
     cols = 20;
     mineCount = 80;
+    chunkedMode = false;
     resetGrid();
 }
 
 void Widget::setCustomise(){
     rows = rowsInput->text().toInt();
     cols = colsInput->text().toInt();
-    mineCount = mineCountInput->text().toInt();
-    if(rows*cols >= mineCount)
-        resetGrid();
+    qint64 mines = mineCountInput->text().toLongLong();  // 超大盤面的地雷數可能超過 int
+    if (rows <= 0 || cols <= 0 || qint64(rows) * cols < mines) return;
 
+    // 太大的盤面一次配置不下，改用只配置玩過區塊的 ChunkedBoard
+    chunkedMode = qint64(rows) * cols > chunkedCells;
+    if (chunkedMode) {
+        chunked.reset(rows, cols, mines, QRandomGenerator::global()->generate64());
+    } else {
+        mineCount = int(mines);
+    }
+    resetGrid();
 }
 
-void Widget::resetGrid() {
-    // 刪除舊的布局和按鈕
-    qDeleteAll(findChildren<QPushButton*>());
-    qDeleteAll(findChildren<QLineEdit*>());
-
-    layout = new QGridLayout;
-    grid = QVector<QVector<int>>(rows, QVector<int>(cols, 0));
-    flags = QVector<QVector<bool>>(rows, QVector<bool>(cols, false));
-    buttons.clear();
-
-    setButton(); // 根據新的行數和列數創建按鈕
-    initializeGame();  // 初始化遊戲
-
-    mainLayout->addLayout(layout);
+void Widget::setEndless(){
+    chunkedMode = true;
+    chunked.resetEndless(QRandomGenerator::global()->generate64(), endlessDensity);
+    resetGrid();
 }
 
-void Widget::resetGame() {
-    flagCount = 0;
-    cerrectCount = 0;
-    if (grid.size() != rows) grid.resize(rows);
-        grid.fill(QVector<int>(cols, 0));
-
-    if (flags.size() != rows) flags.resize(rows);
-        flags.fill(QVector<bool>(cols, false));
-
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            buttons[i][j]->setEnabled(true);
-            buttons[i][j]->setText("");
-            buttons[i][j]->installEventFilter(this);
-
-            disconnect(buttons[i][j], &QPushButton::clicked, nullptr, nullptr);
-            connect(buttons[i][j], &QPushButton::clicked, this, &Widget::onButtonClicked);
+void Widget::updateSwapFile() {
+    // 無限模式走越遠存起來的區越多，超過 endlessMemory 就寫到暫存資料夾裡的檔案；
+    // 不是無限模式就關掉檔案並刪掉
+    if (chunkedMode && chunked.endless()) {
+        swapPath = QDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation))
+                       .filePath(QString("minesweeper-%1.swap").arg(QCoreApplication::applicationPid()));
+        if (!chunked.setSwapFile(QFile::encodeName(swapPath).toStdString(), endlessMemory)) {
+            qWarning() << "開不了暫存檔，無限模式全部留在記憶體：" << swapPath;
+            chunked.setSwapFile(std::string(), 0);
+            QFile::remove(swapPath);
+            swapPath.clear();
         }
+        return;
     }
-    initializeGame();
+    if (swapPath.isEmpty()) return;
+    if (chunked.endless()) chunked.reset(0, 0, 0, 0);  // 先丟掉無限模式的盤面，不用把暫存檔讀回記憶體
+    chunked.setSwapFile(std::string(), 0);
+    QFile::remove(swapPath);
+    swapPath.clear();
 }
 
-
-void Widget::setButton(){
-    for (int i = 0; i < rows; ++i) {
-        QVector<QPushButton*> buttonRow;
-        for (int j = 0; j < cols; ++j) {
-            QPushButton *button = new QPushButton(this);
-            button->setFixedSize(30, 30);  // 設定格子大小
-            layout->addWidget(button, i, j);
-            buttonRow.append(button);
-
-            connect(button, &QPushButton::clicked, this, &Widget::onButtonClicked);
-            button->installEventFilter(this);  // 安裝事件過濾器
-
-            button->setProperty("row",i);
-            button->setProperty("col",j);//設定按鈕座標
-        }
-        buttons.append(buttonRow);
+void Widget::resetGrid() {
+    // 刪除舊的按鈕和輸入框
+    qDeleteAll(findChildren<QPushButton*>());
+    qDeleteAll(findChildren<QLineEdit*>());
+    qDeleteAll(findChildren<QCheckBox*>());
+    cancelNoGuess();  // 換了大小或模式，之前等的盤面不要了
+    updateSwapFile();
+
+    if (chunkedMode) {
+        boardView = new BoardView(&chunked, this);
+        connect(boardView, &BoardView::positionClicked, this, &Widget::onPositionClicked);
+        connect(boardView, &BoardView::positionRightClicked, this, &Widget::onPositionRightClicked);
+        connect(boardView, &BoardView::positionChorded, this, [this](int row, int col) {
+            clickSound.play();
+            revealPosition(row, col, true);
+        });
+    } else {
+        board.resize(rows, cols, mineCount);
+        boardView = new BoardView(&board, this);
+        connect(boardView, &BoardView::cellClicked, this, &Widget::onCellClicked);
+        connect(boardView, &BoardView::cellRightClicked, this, &Widget::onRightClick);
+        connect(boardView, &BoardView::cellChorded, this, [this](int index) {
+            if (replaying) return;
+            clickSound.play();
+            reveal(index, true);
+        });
     }
-    setCentralWidget(centralWidget);
-}
+    boardView->setProfiler(&profiler);
+    connect(boardView, &BoardView::batchApplied, this, [this](int cells) {
+        statusBar()->showMessage(QString("本次更新 %1 格").arg(cells));  // 每一步實際重畫了多少格子
+    });
+    connect(boardView, &BoardView::zoomChanged, this, [this](int cellSize) {
+        statusBar()->showMessage(QString("格子大小 %1 px").arg(cellSize));
+    });
 
-bool Widget::eventFilter(QObject *obj, QEvent *event) {
-    if (event->type() == QEvent::MouseButtonRelease) {
-        QMouseEvent *mouseEvent = static_cast<QMouseEvent *>(event);
-        if (mouseEvent->button() == Qt::RightButton) {
-            QPushButton *button = qobject_cast<QPushButton *>(obj);  // 獲取點擊的按鈕
-            if (button) {
-                onRightClick(button);  // 處理右鍵事件
-                return true;  // 阻止事件繼續傳遞
-            }
-        }
+    mainLayout->addWidget(boardView);
+    if (chunkedMode) {
+        // 從盤面中央 (無限模式是原點) 開始，等版面排好才知道畫面多大
+        int centerRow = chunked.endless() ? 0 : chunked.rows() / 2;
+        int centerCol = chunked.endless() ? 0 : chunked.cols() / 2;
+        QTimer::singleShot(0, boardView, [this, centerRow, centerCol]() { boardView->centerOn(centerRow, centerCol); });
+        statusBar()->showMessage(chunked.endless() ? "無限模式：捲動到哪裡盤面就產生到哪裡" : "超大盤面：只會配置玩過的區塊");
+        return;
     }
-    return QMainWindow::eventFilter(obj, event);  // 交給父類處理其他事件
+    initializeBoard();  // 初始化遊戲
+    setHeatmap(heatmap);
 }
 
-void Widget::onRightClick(QPushButton *button) {
-    int girdvalue = grid[button->property("row").toInt()][button->property("col").toInt()];
-    if (button->text() == "🚩") {
-        button->setText("");  // 移除旗子
-        flags[button->property("row").toInt()][button->property("col").toInt()] = false;  // 設置旗子狀態為false
-        flagSound.play();  // 播放旗子音效
+void Widget::startNoGuess() {
+    // 跟 setEasy / setNormal / setHard 一樣
+    generator.start({ { 10, 10, 10 }, { 15, 15, 60 }, { 20, 20, 80 } });
+}
 
-        flagCount--;
-        if(girdvalue == -1){
-            cerrectCount--;
-        }
-        if(mineCount == cerrectCount && mineCount == flagCount){
-            winSound.play();
-            resetGame();
+void Widget::initializeBoard() {
+    startIndex = -1;
+    if (replaying) { // 照重播檔的種子產生同一個盤面，再一步一步播放
+        replayPlayer.start(playback, board);
+        solver.reset(&board);
+        solverStale = false;
+        journal.clear();
+        statusBar()->showMessage(QString("重播 %1 步：1~9 倍速，0 最快，R 結束").arg(playback.moves.size()));
+        scheduleReplayStep();
+        return;
+    }
+    cancelNoGuess();
+    if (noGuess) {
+        NoGuessGenerator::Config config{ rows, cols, mineCount };
+        NoGuessGenerator::Result result;
+        generator.request(config);  // 自訂大小這時才開始找，拿到一個就不再準備
+        if (generator.take(config, &result)) {
+            board.initializeGame(result.seed, result.startRow, result.startCol);
+            startIndex = board.index(result.startRow, result.startCol);
+        } else {
+            waitingNoGuess = true;  // 不等：先玩一般盤面，找到時還沒動過就換掉 (noGuessFound)
+            waitingConfig = config;
         }
+    }
+    if (startIndex < 0) board.prepareGame();  // 地雷等到第一下才放，第一下一定安全
+    solver.reset(&board);
+    solverStale = false;
+    journal.clear();
+    recording.start(board, startIndex >= 0 ? board.rowOf(startIndex) * cols + board.colOf(startIndex) : -1);
+    moveTimer.start();
+
+    if (startIndex >= 0) {
+        boardView->setHint(startIndex);
+        statusBar()->showMessage("從框起來的格子開始，整局都不用猜");
+    } else if (waitingNoGuess) {
+        statusBar()->showMessage("正在找不用猜的盤面…先點下去的話這局就是一般盤面");
+    }
+}
 
-    } else {
-        if(button->isEnabled() == true){
-            button->setText("🚩");  // 放置旗子
-            flags[button->property("row").toInt()][button->property("col").toInt()] = true;  // 設置旗子狀態為true
-            flagSound.play();  // 播放旗子音效
-            flagCount++;
-
-            if(girdvalue == -1){
-                cerrectCount++;
+void Widget::cancelNoGuess() {
+    if (!waitingNoGuess) return;
+    waitingNoGuess = false;
+    generator.cancel(waitingConfig);  // 背景不用再幫這個大小找了
+}
 
-            }
-            if(mineCount == cerrectCount && mineCount == flagCount){
-                winSound.play();
-                revealAllBombs();
-                disableAllButtons();
-            }
+void Widget::noGuessFailed(const NoGuessGenerator::Config &config) {
+    if (!waitingNoGuess || !(config == waitingConfig)) return;
+    waitingNoGuess = false;
+    statusBar()->showMessage("找不到不用猜的盤面…這局就是一般盤面");
+}
 
-        }
-    }
+void Widget::noGuessFound(const NoGuessGenerator::Config &config) {
+    if (!waitingNoGuess || !noGuess || !boardView || chunkedMode || replaying) return;
+    if (config.rows != rows || config.cols != cols || config.mineCount != mineCount) return;
+    NoGuessGenerator::Result result;
+    if (!generator.take(config, &result)) return;  // 已經被拿走了
+
+    // 盤面還沒動過 (recordMove 會把 waitingNoGuess 清掉)，直接在同一個盤面放地雷
+    waitingNoGuess = false;
+    board.initializeGame(result.seed, result.startRow, result.startCol);
+    startIndex = board.index(result.startRow, result.startCol);
+    solver.reset(&board);
+    solverStale = false;
+    recording.start(board, result.startRow * cols + result.startCol);
+    moveTimer.start();
+    boardView->setHint(startIndex);
+    updateHeatmap();
+    statusBar()->showMessage("從框起來的格子開始，整局都不用猜");
 }
 
-void Widget::onButtonClicked() {
-    QPushButton *button = qobject_cast<QPushButton*>(sender());
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            if (buttons[i][j] == button) {
-                if (flags[i][j]) return;
-                clickSound.play();                // 如果該格子已經放置了旗子，則不處理點擊
-                reveal(i, j);
-                return;
-            }
+void Widget::resetGame() {
+    if (!boardView) return;
+
+    if (chunkedMode) { // 換一個種子就是新的盤面，不用清任何格子
+        uint64_t seed = QRandomGenerator::global()->generate64();
+        if (chunked.endless()) {
+            chunked.resetEndless(seed, endlessDensity);
+            updateSwapFile();  // 新的一局從空的暫存檔開始
+        } else {
+            chunked.reset(chunked.rows(), chunked.cols(), chunked.mineCount(), seed);
         }
+        boardView->boardResized();
+        return;
     }
+
+    // 盤面直接清成全新的狀態 (不重新配置記憶體)，只重畫原本打開過或插過旗子的格子
+    stopReplay();
+    board.clear();
+    boardView->updateCells(board.changedCells());
+    initializeBoard();
+    updateHeatmap();
 }
 
-void Widget::initializeGame() {
-    // 隨機放置地雷
-    for (int i = 0; i < mineCount;) {
-        int r = QRandomGenerator::global()->bounded(rows);
-        int c = QRandomGenerator::global()->bounded(cols);
-        if (grid[r][c] != -1) { // 避免重複放置地雷
-            grid[r][c] = -1;
-            ++i;
+void Widget::onRightClick(int index) {
+    if (replaying) return;
+    QElapsedTimer timer;
+    timer.start();
+    MinesweeperBoard::GameState before = board.state();
+    MinesweeperBoard::FlagResult result = board.toggleFlagAt(index);
+    profiler.record(LatencyProfiler::Rules, timer.nsecsElapsed());
+    if (result == MinesweeperBoard::FlagResult::Ignored) return;
+    journal.record(board, before);
+    recordMove(Replay::Action::Flag, index);
+    if (!solverStale) solver.update(board.changedCells());
+
+    flagSound.play();  // 播放旗子音效
+    timer.restart();
+    boardView->updateCells(board.changedCells());
+    profiler.record(LatencyProfiler::UiUpdate, timer.nsecsElapsed());
+
+    if (board.state() == MinesweeperBoard::GameState::Won) {
+        winSound.play();
+        if (result == MinesweeperBoard::FlagResult::Removed) {
+            resetGame();
+        } else {
+            revealAllBombs();
         }
     }
+}
 
-    // 計算每個格子的周圍地雷數
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            if (grid[i][j] == -1) continue;
-            grid[i][j] = countMinesAround(i, j);
-        }
-    }
+void Widget::onCellClicked(int index) {
+    if (replaying) return;
+    if (board.cellState(index) == MinesweeperBoard::CellState::Flagged) return;  // 如果該格子已經放置了旗子，則不處理點擊
+    clickSound.play();
+    reveal(index);
 }
 
-int Widget::countMinesAround(int row, int col) {
-    int mineCount = 0;
-    for (int i = -1; i <= 1; ++i) {
-        for (int j = -1; j <= 1; ++j) {
-            if (i == 0 && j == 0) continue; // 忽略自己
-            int newRow = row + i;
-            int newCol = col + j;
-            if (isValid(newRow, newCol) && grid[newRow][newCol] == -1) {
-                ++mineCount;
-            }
-        }
-    }
-    return mineCount;
+void Widget::onPositionClicked(int row, int col) {
+    if (chunked.cell(row, col) & MinesweeperBoard::FlagBit) return;
+    clickSound.play();
+    revealPosition(row, col, false);
 }
 
-void Widget::reveal(int row, int col) {
-    if (!isValid(row, col) || buttons[row][col]->isEnabled() == false) return;
+void Widget::revealPosition(int row, int col, bool chord) {
+    QElapsedTimer timer;
+    timer.start();
+    ChunkedBoard::RevealResult result = chord ? chunked.chord(row, col) : chunked.reveal(row, col);
+    profiler.record(LatencyProfiler::Rules, timer.nsecsElapsed());
+    if (result == ChunkedBoard::RevealResult::Ignored) return;
 
-    buttons[row][col]->setEnabled(false);
+    timer.restart();
+    boardView->updatePositions(chunked.changedCells());
+    profiler.record(LatencyProfiler::UiUpdate, timer.nsecsElapsed());
 
-    if (grid[row][col] == -1) { // 點到地雷
-        buttons[row][col]->setText("💣");
+    if (result == ChunkedBoard::RevealResult::Exploded) { // 盤面太大，不打開所有地雷，只顯示踩到的那一個
         mineSound.play();
-        revealAllBombs();
-        disableAllButtons();
-    } else if (grid[row][col] > 0) { // 點到數字
-        buttons[row][col]->setText(QString::number(grid[row][col]));
-    } else { // 點到空白
-        buttons[row][col]->setText("");
-        expandEmptyArea(row, col);
+        showGameOver();
+    } else if (chunked.state() == ChunkedBoard::GameState::Won) { // 安全的格子都打開了
+        winSound.play();
+        showGameOver();
     }
 }
 
-bool Widget::isValid(int row, int col) {
-    return row >= 0 && row < rows && col >= 0 && col < cols;
-}
-
-void Widget::expandEmptyArea(int row, int col) {
-    QQueue<QPoint> queue;
-    QSet<QPoint> visited;  // 用來記錄已經處理的格子
-    queue.enqueue(QPoint(row, col));
+void Widget::onPositionRightClicked(int row, int col) {
+    ChunkedBoard::FlagResult result = chunked.toggleFlag(row, col);
+    if (result == ChunkedBoard::FlagResult::Ignored) return;
+    flagSound.play();
+    boardView->updatePositions(chunked.changedCells());
 
-    while (!queue.isEmpty()) {
-        QPoint point = queue.dequeue();
-        int r = point.x();
-        int c = point.y();
-
-        if (!isValid(r, c) || visited.contains(QPoint(r, c))) continue;
-
-        visited.insert(QPoint(r, c));
-        buttons[r][c]->setEnabled(false);
-        buttons[r][c]->setText(""); // 顯示空白
+    if (chunked.state() == ChunkedBoard::GameState::Won) {
+        winSound.play();
+        showGameOver();
+    }
+}
 
-        if (grid[r][c] == 0) {
-            // 如果該區域是空白，繼續將周圍區域加入隊列
-            for (int i = -1; i <= 1; ++i) {
-                for (int j = -1; j <= 1; ++j) {
-                    if (i == 0 && j == 0) continue;
-                    queue.enqueue(QPoint(r + i, c + j));
-                }
-            }
-        } else if (grid[r][c] > 0) {
-            buttons[r][c]->setText(QString::number(grid[r][c]));
-        }
+void Widget::reveal(int index, bool chord) {
+    QElapsedTimer timer;
+    timer.start();
+    MinesweeperBoard::GameState before = board.state();
+    MinesweeperBoard::RevealResult result = chord ? board.chordAt(index) : board.revealAt(index);
+    qint64 floodFill = board.lastFloodFillNanos();
+    profiler.record(LatencyProfiler::Rules, timer.nsecsElapsed() - floodFill);
+    if (floodFill > 0) profiler.record(LatencyProfiler::FloodFill, floodFill);
+    if (result == MinesweeperBoard::RevealResult::Ignored) return;
+    journal.record(board, before);
+    recordMove(chord ? Replay::Action::Chord : Replay::Action::Reveal, index);
+    if (!solverStale) solver.update(board.changedCells());
+
+    timer.restart();
+    boardView->updateCells(board.changedCells());
+    profiler.record(LatencyProfiler::UiUpdate, timer.nsecsElapsed());
+    if (result == MinesweeperBoard::RevealResult::Opened) updateHeatmap();  // 旗子不影響機率，只有打開格子才要重算
+
+    if (result == MinesweeperBoard::RevealResult::Exploded) { // 點到地雷
+        mineSound.play();
+        revealAllBombs();
+    } else if (board.state() == MinesweeperBoard::GameState::Won) { // 安全的格子都打開了
+        winSound.play();
+        revealAllBombs();
     }
 }
 
 void Widget::revealAllBombs() {
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            if (grid[i][j] == -1) {
-                buttons[i][j]->setText("💣");
-            } else if (grid[i][j] > 0) {
-                buttons[i][j]->setText(QString::number(grid[i][j]));
-            }
-            buttons[i][j]->setEnabled(false);
-        }
+    MinesweeperBoard::GameState before = board.state();
+    board.revealAllBombs();
+    // 踩到地雷或贏了之後打開的格子併進最後一步，悔棋時一起還原；還在玩的時候按 T 自己算一步
+    if (before == MinesweeperBoard::GameState::Playing) {
+        journal.record(board, before);
+        recordMove(Replay::Action::RevealAll, -1);
+    } else {
+        journal.append(board);
     }
+    boardView->updateCells(board.changedCells());
+    showGameOver();
+}
+
+void Widget::showGameOver() {
+    QString replayDir = qEnvironmentVariable("MINESWEEPER_REPLAY_DIR");
+    if (!chunkedMode && !replaying && !replayDir.isEmpty()) {
+        saveReplay(QDir(replayDir).filePath(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz") + ".msr"));
+    }
+
     QMessageBox *messageBox = new QMessageBox(this);
     messageBox->setWindowTitle("Game Over");
     messageBox->setText("遊戲結束! 再來一場?");
@@ -350,19 +489,254 @@ void Widget::revealAllBombs() {
 }
 
 
-void Widget::disableAllButtons() {
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            buttons[i][j]->setEnabled(false); // 禁用所有按鈕
+void Widget::keyPressEvent(QKeyEvent *event) {
+    if (!boardView) return;  // 還在選擇難度
+
+    if (event->key() == Qt::Key_Plus || event->key() == Qt::Key_Equal) { // 放大
+        boardView->zoomBy(1);
+        return;
+    } else if (event->key() == Qt::Key_Minus) { // 縮小
+        boardView->zoomBy(-1);
+        return;
+    }
+    if (event->matches(QKeySequence::Open)) { // Ctrl+O 播放重播檔
+        openReplay();
+        return;
+    }
+    if (replaying) {
+        if (event->key() >= Qt::Key_0 && event->key() <= Qt::Key_9) {
+            replaySpeed = event->key() - Qt::Key_0;
+            statusBar()->showMessage(replaySpeed ? QString("重播速度 %1 倍").arg(replaySpeed) : QString("重播速度：最快"));
+            return;
         }
+        const int key = event->key();
+        if (key != Qt::Key_R && key != Qt::Key_H && key != Qt::Key_P && key != Qt::Key_L) return;  // 重播中不能改變盤面
+    }
+
+    const bool undoKey = event->matches(QKeySequence::Undo) || event->matches(QKeySequence::Redo);  // Ctrl+Z / Ctrl+Y
+    if (chunkedMode && (undoKey || event->matches(QKeySequence::Save))) {
+        statusBar()->showMessage("超大盤面和無限模式不支援悔棋和重播");
+        return;
+    }
+    if (event->matches(QKeySequence::Save)) { // Ctrl+S 把這一局存成重播檔
+        QString path = QFileDialog::getSaveFileName(this, "儲存重播", qEnvironmentVariable("MINESWEEPER_REPLAY_DIR"), "重播檔 (*.msr)");
+        if (!path.isEmpty()) saveReplay(path);
+        return;
+    }
+    if (undoKey) {
+        undoMove(event->matches(QKeySequence::Redo));
+        return;
+    }
+    if (chunkedMode && (event->key() == Qt::Key_T || event->key() == Qt::Key_H || event->key() == Qt::Key_P)) {
+        statusBar()->showMessage("超大盤面和無限模式不支援顯示地雷、提示和機率");
+        return;
     }
-}
 
-void Widget::keyPressEvent(QKeyEvent *event) {
     if (event->key() == Qt::Key_T) { // 調試模式：顯示所有地雷
         revealAllBombs();
     } else if (event->key() == Qt::Key_R) { // 重置遊戲
         resetGame();
+    } else if (event->key() == Qt::Key_H) { // 提示
+        showHint();
+    } else if (event->key() == Qt::Key_P) { // 機率熱圖
+        setHeatmap(!heatmap);
+    } else if (event->key() == Qt::Key_L) { // 調試模式：顯示每一步的延遲
+        setProfiling(!profiler.isEnabled());
+    } else if (event->key() == Qt::Key_S && profiler.isEnabled()) { // 把延遲統計存成 CSV
+        QString path = qEnvironmentVariable("MINESWEEPER_PROFILE_CSV", "latency.csv");
+        if (profiler.writeCsv(path)) {
+            statusBar()->showMessage(QString("已輸出 %1").arg(QDir::toNativeSeparators(QFileInfo(path).absoluteFilePath())));
+        } else {
+            statusBar()->showMessage(QString("無法寫入 %1").arg(path));
+        }
+    }
+}
+
+void Widget::showHint() {
+    if (board.state() != MinesweeperBoard::GameState::Playing) return;
+
+    QElapsedTimer timer;
+    timer.start();
+    syncSolver();
+    solver.solve();
+
+    // 先找沒插旗子的安全格子，沒有的話再找還沒插旗子的地雷
+    int hint = -1;
+    bool mine = false;
+    for (int index : solver.safeCells()) {
+        if (!(board.cell(index) & MinesweeperBoard::FlagBit)) {
+            hint = index;
+            break;
+        }
+    }
+    if (hint < 0) {
+        for (int index : solver.mineCells()) {
+            if (!(board.cell(index) & MinesweeperBoard::FlagBit)) {
+                hint = index;
+                mine = true;
+                break;
+            }
+        }
+    }
+
+    boardView->setHint(hint, mine);
+    QString elapsed = LatencyProfiler::formatNanos(timer.nsecsElapsed());
+    if (hint < 0) {
+        statusBar()->showMessage(QString("沒有可以確定的格子，只能用猜的 (%1)").arg(elapsed));
+    } else {
+        statusBar()->showMessage(QString("提示：第 %1 行第 %2 列%3 (%4)")
+                                     .arg(board.rowOf(hint) + 1).arg(board.colOf(hint) + 1)
+                                     .arg(mine ? "是地雷" : "是安全的").arg(elapsed));
+    }
+}
+
+void Widget::setHeatmap(bool enabled) {
+    heatmap = enabled;
+    if (!boardView) return;
+    if (heatmap) {
+        updateHeatmap();
+    } else {
+        boardView->setProbabilities(nullptr);
+    }
+}
+
+void Widget::updateHeatmap() {
+    if (!heatmap || !boardView) return;
+
+    QElapsedTimer timer;
+    timer.start();
+    syncSolver();
+    solver.solve();
+    probabilities.compute(board, solver);
+    boardView->setProbabilities(&probabilities);
+    statusBar()->showMessage(QString("機率：%1 個區域 (沿用 %2)%3，%4")
+                                 .arg(probabilities.componentCount())
+                                 .arg(probabilities.reusedComponents())
+                                 .arg(probabilities.isExact() ? "" : "，部分是估計值")
+                                 .arg(LatencyProfiler::formatNanos(timer.nsecsElapsed())));
+}
+
+void Widget::undoMove(bool redo) {
+    QElapsedTimer timer;
+    timer.start();
+    if (!(redo ? journal.redo(board) : journal.undo(board))) {
+        statusBar()->showMessage(redo ? "沒有可以重做的步驟" : "沒有可以悔棋的步驟");
+        return;
+    }
+    qint64 elapsed = timer.nsecsElapsed();
+    solverStale = true;  // 蓋回去的格子 solver 沒辦法只更新一部分
+
+    boardView->updateCells(board.changedCells());
+    updateHeatmap();
+    recordMove(redo ? Replay::Action::Redo : Replay::Action::Undo, -1);
+    statusBar()->showMessage(QString("%1：%2 格 (%3)，還可以悔 %4 步、重做 %5 步")
+                                 .arg(redo ? "重做" : "悔棋")
+                                 .arg(board.changedCells().size())
+                                 .arg(LatencyProfiler::formatNanos(elapsed))
+                                 .arg(journal.undoCount()).arg(journal.redoCount()));
+}
+
+void Widget::recordMove(Replay::Action action, int index) {
+    if (waitingNoGuess) { // 玩家已經開始了，這局就是一般盤面
+        cancelNoGuess();
+        statusBar()->clearMessage();
+    }
+    int cell = index >= 0 ? board.rowOf(index) * board.cols() + board.colOf(index) : 0;
+    recording.add(action, cell, uint64_t(moveTimer.nsecsElapsed() / 1000));
+    moveTimer.restart();
+}
+
+bool Widget::saveReplay(const QString &path) {
+    recording.setOutcome(board.state());
+    const std::vector<uint8_t> bytes = recording.encode();
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(reinterpret_cast<const char *>(bytes.data()), qint64(bytes.size())) != qint64(bytes.size())) {
+        statusBar()->showMessage(QString("無法寫入 %1").arg(path));
+        return false;
+    }
+    statusBar()->showMessage(QString("已存成重播 %1 (%2 步，%3 bytes)")
+                                 .arg(QDir::toNativeSeparators(path)).arg(recording.moves.size()).arg(bytes.size()));
+    return true;
+}
+
+void Widget::openReplay() {
+    QString path = QFileDialog::getOpenFileName(this, "開啟重播", qEnvironmentVariable("MINESWEEPER_REPLAY_DIR"), "重播檔 (*.msr)");
+    if (path.isEmpty()) return;
+    QFile file(path);
+    QByteArray bytes;
+    if (file.open(QIODevice::ReadOnly)) bytes = file.readAll();
+    Replay loaded;  // 讀好了才換掉，播放中的重播不受影響
+    if (!loaded.decode(reinterpret_cast<const uint8_t *>(bytes.constData()), size_t(bytes.size()))) {
+        statusBar()->showMessage(QString("無法讀取 %1").arg(path));
+        return;
+    }
+    if (qint64(loaded.rows) * loaded.cols > chunkedCells) {
+        statusBar()->showMessage("重播檔的盤面太大");
+        return;
+    }
+
+    // 用重播檔的大小重新開一個盤面
+    stopReplay();
+    playback = std::move(loaded);
+    rows = playback.rows;
+    cols = playback.cols;
+    mineCount = playback.mineCount;
+    chunkedMode = false;
+    delete boardView;
+    boardView = nullptr;
+    replaying = true;
+    resetGrid();  // initializeBoard 會開始播放
+}
+
+void Widget::scheduleReplayStep() {
+    if (replayPlayer.atEnd()) {
+        const char *result = board.state() == MinesweeperBoard::GameState::Won    ? "贏了"
+                             : board.state() == MinesweeperBoard::GameState::Lost ? "輸了"
+                                                                                  : "還沒結束";
+        statusBar()->showMessage(QString("重播結束：%1%2 (R 開始新的一局)")
+                                     .arg(result)
+                                     .arg(replayPlayer.ignoredMoves() ? QString("，%1 步對不上").arg(replayPlayer.ignoredMoves()) : QString()));
+        return;
+    }
+    // 即時播放就照記錄的間隔等，N 倍速等 1/N，最快就不等
+    qint64 delay = replaySpeed > 0 ? qint64(replayPlayer.nextDelayMicros() / 1000) / replaySpeed : 0;
+    replayTimer.start(int(std::min<qint64>(delay, std::numeric_limits<int>::max())));
+}
+
+void Widget::replayStep() {
+    // 最快速度時一次做好幾步，大約一個畫面的時間才回到事件迴圈重畫
+    QElapsedTimer timer;
+    timer.start();
+    do {
+        replayPlayer.step();
+        boardView->updateCells(replayPlayer.changedCells());
+    } while (replaySpeed == 0 && !replayPlayer.atEnd() && timer.elapsed() < 16);
+    solverStale = true;
+    updateHeatmap();
+    scheduleReplayStep();
+}
+
+void Widget::stopReplay() {
+    replayTimer.stop();
+    replaying = false;
+}
+
+void Widget::syncSolver() {
+    if (!solverStale) return;
+    solver.reset(&board);
+    solverStale = false;
+}
+
+void Widget::setProfiling(bool enabled) {
+    profiler.setEnabled(enabled);
+    board.setTimingEnabled(enabled);
+    if (enabled) {
+        profiler.reset();
+        overlayTimer.start();
+    } else {
+        overlayTimer.stop();
     }
+    if (boardView) boardView->refreshOverlay();
 }
 
@@ -17,6 +17,18 @@
 #include <QSize>
 #include <QSet>
 #include <QSoundEffect>
+#include <QTimer>
+#include <QCheckBox>
+#include <QElapsedTimer>
+#include "chunkedboard.h"
+#include "minesweeperboard.h"
+#include "movejournal.h"
+#include "noguessgenerator.h"
+#include "probabilityengine.h"
+#include "replay.h"
+#include "solver.h"
+#include "boardview.h"
+#include "latencyprofiler.h"
 class Widget : public QMainWindow
 {
     Q_OBJECT
@@ -29,8 +41,6 @@ private:
     int rows = 10;          // 行數
     int cols = 10;          // 列數
     int mineCount = 10;     // 地雷數量
-    int flagCount = 0;
-    int cerrectCount = 0;
 
     QLineEdit *rowsInput;
     QLineEdit *colsInput;
@@ -38,32 +48,71 @@ private:
     QWidget *centralWidget;
     QVBoxLayout *mainLayout;
 
-    QGridLayout *layout;          // 網格佈局
-    QVector<QVector<int>> grid;  // 儲存遊戲格子狀態，-1 代表地雷
-    QVector<QVector<QPushButton*>> buttons;  // 儲存所有按鈕
-    QVector<QVector<bool>> flags; // 儲存格子是否放置旗子
+    MinesweeperBoard board;       // 遊戲邏輯 (格子狀態、旗子、地雷)
+    ChunkedBoard chunked;         // 超大的自訂盤面和無限模式 (只配置玩過的區塊)
+    bool chunkedMode = false;     // 目前用的是 chunked 不是 board
+    static constexpr qint64 chunkedCells = 2048 * 2048;  // 自訂盤面超過這個格子數就用 ChunkedBoard
+    static constexpr double endlessDensity = 0.18;       // 無限模式的地雷密度
+    static constexpr size_t endlessMemory = 64 << 20;    // 無限模式存起來的區超過這麼多 byte 就寫到暫存檔
+    QString swapPath;             // 無限模式的暫存檔 (空的代表沒有開)
+    BoardView *boardView = nullptr;  // 畫出盤面的元件
+    Solver solver;                   // 提示用的推論，每一步之後只更新改變的部分
+    bool solverStale = false;        // 悔棋之後 solver 要重新開始 (等到要用的時候才做)
+    MoveJournal journal;             // 悔棋 (Ctrl+Z) 和重做 (Ctrl+Y)
+    ProbabilityEngine probabilities; // 熱圖用的地雷機率 (P 開關)
+    bool heatmap = false;
+    NoGuessGenerator generator;      // 背景準備不用猜的盤面
+    bool noGuess = false;            // 不用猜模式
+    int startIndex = -1;             // 不用猜的盤面要從這格開始
+    bool waitingNoGuess = false;     // 先給了一般盤面，背景找到不用猜的盤面時再換上去
+    NoGuessGenerator::Config waitingConfig{};  // 正在等的是哪個大小
+    LatencyProfiler profiler;        // 每一次點擊的延遲量測 (L 開關，S 輸出 CSV)
+    QTimer overlayTimer;             // 定時更新畫面上的量測結果
+    Replay recording;                // 這一局的重播記錄 (Ctrl+S 存檔；設定 MINESWEEPER_REPLAY_DIR 時每局結束自動存)
+    QElapsedTimer moveTimer;         // 跟上一步相差多久
+    Replay playback;                 // Ctrl+O 開啟的重播檔
+    ReplayPlayer replayPlayer;
+    QTimer replayTimer;              // 等到下一步的時間
+    bool replaying = false;          // 重播中 (不接受點擊)
+    int replaySpeed = 1;             // 重播速度：1~9 倍，0 是最快
 
 
-    void initializeGame();  // 初始化遊戲
-
     void theDifficultyWidget(); // 選擇難度介面
     void setEasy();
     void setNormal();
     void setHard();
     void setCustomise();
+    void setEndless();  // 無限模式
 
     void resetGrid(); // 重置陣列
-    void setButton(); // 設定操控按鈕
+    void updateSwapFile();  // 無限模式開暫存檔，離開無限模式就關掉刪掉
+    void initializeBoard();  // 放地雷 (不用猜模式時拿背景準備好的盤面)
+    void startNoGuess();  // 開始在背景準備內建難度的不用猜盤面
+    void noGuessFound(const NoGuessGenerator::Config &config);  // 背景找到盤面 (排進畫面的執行緒才呼叫)
+    void noGuessFailed(const NoGuessGenerator::Config &config);  // 背景放棄了 (同上)
+    void cancelNoGuess();  // 不等背景的盤面了 (玩家已經開始或換了大小)
 
-    void reveal(int row, int col);  // 顯示格子的內容
-    bool isValid(int row, int col);  // 檢查格子是否有效
-    int countMinesAround(int row, int col);  // 計算周圍地雷數量
-    void expandEmptyArea(int row, int col);  // 展開空白區域
+    void reveal(int index, bool chord = false);  // 顯示格子的內容 (chord：打開數字周圍沒插旗子的格子)
+    void revealPosition(int row, int col, bool chord);  // 同上 (ChunkedBoard)
     void revealAllBombs();  // 顯示所有地雷
-    void disableAllButtons();  // 禁用所有按鈕
+    void showGameOver();  // 問玩家要不要再來一場
     void resetGame();  // 重置遊戲
-    void onRightClick(QPushButton *button);  // 右鍵點擊事件處理
-    void onButtonClicked();  // 按鈕點擊事件處理
+    void onRightClick(int index);  // 右鍵點擊事件處理
+    void onCellClicked(int index);  // 格子點擊事件處理
+    void onPositionClicked(int row, int col);  // 同上 (ChunkedBoard)
+    void onPositionRightClicked(int row, int col);
+    void setProfiling(bool enabled);  // 開關延遲量測
+    void showHint();  // 標出一個一定安全 (或一定是地雷) 的格子
+    void setHeatmap(bool enabled);  // 開關機率熱圖
+    void updateHeatmap();  // 盤面改變後重新計算機率
+    void undoMove(bool redo);  // 悔一步 (或重做一步)，只重畫還原的格子
+    void syncSolver();  // 悔棋之後第一次用到 solver 時重新開始
+    void recordMove(Replay::Action action, int index);  // 記進重播 (index 是 MinesweeperBoard::index，-1 代表沒有格子)
+    bool saveReplay(const QString &path);
+    void openReplay();  // 選一個重播檔，用它的種子開一局並開始播放
+    void scheduleReplayStep();  // 依照速度等到下一步
+    void replayStep();
+    void stopReplay();
 
     QSoundEffect clickSound;
     QSoundEffect flagSound;
@@ -71,7 +120,6 @@ private:
     QSoundEffect winSound;
 
 protected:
-    bool eventFilter(QObject *obj, QEvent *event) override;  // 事件過濾器
     void keyPressEvent(QKeyEvent *event) override;  // 鍵盤事件
 
 };